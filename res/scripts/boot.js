@@ -0,0 +1,12 @@
+// Run when the Duktape heap is created, precompiled into "data" by
+// ResourcePack.
+
+function print_spheres() {
+  var s = [];
+  for (var idx = 0; idx < get_sphere_count(); ++idx) {
+    get_sphere(idx, s);
+    gen_print(idx + ": pos " + s[0].toFixed(2) + " " + s[1].toFixed(2) + " " +
+              s[2].toFixed(2) + " vel " + s[3].toFixed(2) + " " +
+              s[4].toFixed(2) + " " + s[5].toFixed(2));
+  }
+}
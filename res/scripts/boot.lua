@@ -0,0 +1,9 @@
+-- Run when the Lua state is created, precompiled into "data" by ResourcePack.
+
+function print_spheres()
+  for idx = 0, get_sphere_count() - 1 do
+    local x, y, z, vx, vy, vz = get_sphere(idx)
+    gen_print(string.format("%d: pos %.2f %.2f %.2f vel %.2f %.2f %.2f", idx,
+                            x, y, z, vx, vy, vz))
+  end
+end
@@ -0,0 +1,154 @@
+#include "battle_sim.h"
+
+// Standard library includes.
+#include <cmath>
+
+BattleSim::BattleSim(const BattleSimParams &params)
+    : sphere{{-1.0F, SPHERE_REST_HEIGHT, 0.0F, params.radius},
+             {0.0F, SPHERE_REST_HEIGHT, 0.0F, params.radius}},
+      sphere_vel{{0.0F, 0.0F, 0.0F}, {0.0F, 0.0F, 0.0F}},
+      sphere_touch_point{{0.0F, 0.0F, 0.0F}, {0.0F, 0.0F, 0.0F}},
+      params(params),
+      sphere_acc{{0.0F, 0.0F, 0.0F}, {0.0F, 0.0F, 0.0F}},
+      sphere_prev_pos{{0.0F, 0.0F, 0.0F}, {0.0F, 0.0F, 0.0F}},
+      floor_box{0.0F, -1.0F, 0.0F, 10.0F, 2.0F, 10.0F},
+      floor_timer(0.0F),
+      collision_timer(0.0F),
+      sphere_collided(false) {}
+
+void BattleSim::start_auto_move(
+    const std::array<float, AUTOMOVE_RANDOM_COUNT> &random) {
+  for (unsigned int idx = 0; idx < 2; ++idx) {
+    const float *dir = random.data() + idx * 3;
+    sphere_vel[idx].x = (dir[0] - 0.5F) * 2.0F * AUTOMOVE_DIR_VAR_MAX;
+    sphere_vel[idx].y = (dir[1] - 0.5F) * 2.0F * AUTOMOVE_DIR_VAR_MAX;
+    sphere_vel[idx].z = (dir[2] - 0.5F) * 2.0F * AUTOMOVE_DIR_VAR_MAX;
+
+    sphere_vel[idx] = SC_SACD_Vec3_Mult(
+        SC_SACD_Vec3_Normalize(sphere_vel[idx]), params.automove_speed);
+
+    sphere_acc[idx].y = -params.drop_acc;
+    sphere[idx].y = params.drop_height;
+  }
+}
+
+void BattleSim::stop_auto_move() {
+  for (unsigned int idx = 0; idx < 2; ++idx) {
+    sphere_acc[idx].x = 0.0F;
+    sphere_acc[idx].y = 0.0F;
+    sphere_acc[idx].z = 0.0F;
+
+    sphere_vel[idx].x = 0.0F;
+    sphere_vel[idx].y = 0.0F;
+    sphere_vel[idx].z = 0.0F;
+
+    sphere[idx].y = SPHERE_REST_HEIGHT;
+  }
+}
+
+BattleSimEvents BattleSim::step(float dt, bool auto_move) {
+  BattleSimEvents events{false, false, 0.0F, {false, false}};
+
+  floor_timer += dt;
+  if (sphere_collided) {
+    collision_timer += dt;
+  }
+
+  for (unsigned int idx = 0; idx < 2; ++idx) {
+    sphere_vel[idx].x += sphere_acc[idx].x * dt;
+    sphere_vel[idx].y += sphere_acc[idx].y * dt;
+    sphere_vel[idx].z += sphere_acc[idx].z * dt;
+
+    sphere_prev_pos[idx].x = sphere[idx].x;
+    sphere_prev_pos[idx].y = sphere[idx].y;
+    sphere_prev_pos[idx].z = sphere[idx].z;
+
+    sphere[idx].x += sphere_vel[idx].x * dt;
+    sphere[idx].y += sphere_vel[idx].y * dt;
+    sphere[idx].z += sphere_vel[idx].z * dt;
+  }
+
+  if (auto_move) {
+    // Check collision with other.
+    bool collided = SC_SACD_Sphere_Collision(sphere[0], sphere[1]) != 0;
+    if (sphere_collided && !collided) {
+      sphere_collided = false;
+      events.separated = true;
+      events.separation_time = collision_timer;
+    } else if (collided) {
+      SC_SACD_Vec3 normal{sphere[0].x - sphere[1].x, sphere[0].y - sphere[1].y,
+                          sphere[0].z - sphere[1].z};
+
+      // Move spheres to point before collision.
+
+      sphere[0].x = sphere_prev_pos[0].x;
+      sphere[0].y = sphere_prev_pos[0].y;
+      sphere[0].z = sphere_prev_pos[0].z;
+      sphere[1].x = sphere_prev_pos[1].x;
+      sphere[1].y = sphere_prev_pos[1].y;
+      sphere[1].z = sphere_prev_pos[1].z;
+
+      // Get projection onto normal.
+
+      float temp = SC_SACD_Dot_Product(normal, normal);
+
+      float dot_product[2] = {
+          SC_SACD_Dot_Product(normal, sphere_vel[0]) / temp,
+          SC_SACD_Dot_Product(normal, sphere_vel[1]) / temp};
+      SC_SACD_Vec3 proj[2] = {
+          SC_SACD_Vec3{dot_product[0] * normal.x, dot_product[0] * normal.y,
+                       dot_product[0] * normal.z},
+          SC_SACD_Vec3{dot_product[1] * normal.x, dot_product[1] * normal.y,
+                       dot_product[1] * normal.z}};
+
+      // Get reflection over normal, and negate it to get desired result.
+
+      sphere_vel[0].x = -(proj[0].x * 2.0F - sphere_vel[0].x);
+      sphere_vel[0].y = -(proj[0].y * 2.0F - sphere_vel[0].y);
+      sphere_vel[0].z = -(proj[0].z * 2.0F - sphere_vel[0].z);
+      sphere_vel[1].x = -(proj[1].x * 2.0F - sphere_vel[1].x);
+      sphere_vel[1].y = -(proj[1].y * 2.0F - sphere_vel[1].y);
+      sphere_vel[1].z = -(proj[1].z * 2.0F - sphere_vel[1].z);
+
+      if (!sphere_collided) {
+        collision_timer = 0.0F;
+      }
+      sphere_collided = true;
+      events.collided = true;
+    }
+  }
+
+  // Check collision with wall.
+  for (unsigned int idx = 0; idx < 2; ++idx) {
+    if (sphere[idx].x - sphere[idx].radius < -params.space_width) {
+      sphere[idx].x = sphere_prev_pos[idx].x;
+      sphere_vel[idx].x = std::abs(sphere_vel[idx].x);
+    } else if (sphere[idx].x + sphere[idx].radius > params.space_width) {
+      sphere[idx].x = sphere_prev_pos[idx].x;
+      sphere_vel[idx].x = -std::abs(sphere_vel[idx].x);
+    }
+
+    if (sphere[idx].z - sphere[idx].radius < -params.space_depth) {
+      sphere[idx].z = sphere_prev_pos[idx].z;
+      sphere_vel[idx].z = std::abs(sphere_vel[idx].z);
+    } else if (sphere[idx].z + sphere[idx].radius > params.space_depth) {
+      sphere[idx].z = sphere_prev_pos[idx].z;
+      sphere_vel[idx].z = -std::abs(sphere_vel[idx].z);
+    }
+
+    // Check collision with ground.
+    if (SC_SACD_Sphere_AABB_Box_Collision(sphere[idx], floor_box)) {
+      sphere_touch_point[idx].x = sphere[idx].x;
+      sphere_touch_point[idx].y = sphere_prev_pos[idx].y - sphere[idx].radius;
+      sphere_touch_point[idx].z = sphere[idx].z;
+      sphere[idx].y = sphere_prev_pos[idx].y;
+      sphere_vel[idx].y = std::abs(sphere_vel[idx].y);
+      floor_timer = 0.0F;
+      events.floor_contact[idx] = true;
+    }
+  }
+
+  return events;
+}
+
+const BattleSimParams &BattleSim::get_params() const { return params; }
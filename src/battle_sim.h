@@ -0,0 +1,88 @@
+#ifndef SEODISPARATE_COM_GANDER_BATTLE_BATTLE_SIM_H_
+#define SEODISPARATE_COM_GANDER_BATTLE_BATTLE_SIM_H_
+
+// Standard library includes.
+#include <array>
+#include <cstddef>
+
+// Third party includes.
+#include <sc_sacd.h>
+
+// Constants.
+constexpr float SPHERE_DROP_ACC = 9.8F;
+
+constexpr float SPACE_WIDTH = 2.5F;
+constexpr float SPACE_DEPTH = 2.5F;
+
+constexpr float FLOOR_TIME_MAX = 1.0F;
+
+constexpr float SPHERE_RADIUS = 0.2F;
+constexpr float SPHERE_REST_HEIGHT = 0.21F;
+constexpr float SPHERE_DROP_HEIGHT = 1.0F;
+
+constexpr float AUTOMOVE_DIR_VAR_MAX = 2.0F;
+constexpr float AUTOMOVE_SPEED = 3.0F;
+
+/// Number of values start_auto_move() takes, three per sphere.
+constexpr std::size_t AUTOMOVE_RANDOM_COUNT = 6;
+
+/// The tunables of a battle, defaulting to what BattleScreen plays.
+struct BattleSimParams {
+  float automove_speed = AUTOMOVE_SPEED;
+  float drop_acc = SPHERE_DROP_ACC;
+  float drop_height = SPHERE_DROP_HEIGHT;
+  float space_width = SPACE_WIDTH;
+  float space_depth = SPACE_DEPTH;
+  float radius = SPHERE_RADIUS;
+};
+
+/// What happened during one BattleSim::step().
+struct BattleSimEvents {
+  /// The spheres hit each other and bounced.
+  bool collided;
+  /// The spheres stopped touching, "separation_time" seconds after they
+  /// first collided.
+  bool separated;
+  float separation_time;
+  /// Per sphere, it bounced off the floor.
+  bool floor_contact[2];
+};
+
+/// The two spheres' movement and collisions, without any rendering, audio, or
+/// input. BattleScreen steers it from the keyboard and draws it, and
+/// GanderBattleSim runs it headless.
+class BattleSim {
+ public:
+  BattleSim(const BattleSimParams &params = {});
+
+  /// Launches the spheres in random directions from the drop height, like
+  /// turning on the auto movement flag. "random" holds values in [0, 1), the
+  /// first three for sphere 0's direction and the rest for sphere 1's.
+  void start_auto_move(
+      const std::array<float, AUTOMOVE_RANDOM_COUNT> &random);
+  /// Stops the spheres and sets them back down on the floor.
+  void stop_auto_move();
+
+  /// Advances "dt" seconds. The spheres only hit each other while
+  /// "auto_move" is set.
+  BattleSimEvents step(float dt, bool auto_move);
+
+  const BattleSimParams &get_params() const;
+
+  // Read by BattleScreen to draw, and "sphere_vel" is set from its input.
+  SC_SACD_Sphere sphere[2];
+  SC_SACD_Vec3 sphere_vel[2];
+  SC_SACD_Vec3 sphere_touch_point[2];
+
+ private:
+  BattleSimParams params;
+  SC_SACD_Vec3 sphere_acc[2];
+  SC_SACD_Vec3 sphere_prev_pos[2];
+  SC_SACD_AABB_Box floor_box;
+  float floor_timer;
+  /// Seconds since the spheres first collided, while "sphere_collided".
+  float collision_timer;
+  bool sphere_collided;
+};
+
+#endif
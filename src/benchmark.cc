@@ -0,0 +1,114 @@
+#include "benchmark.h"
+
+// Standard library includes.
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <vector>
+
+// Third party includes.
+#include <raylib.h>
+
+// Local includes.
+#include "constants.h"
+#include "screen.h"
+#include "screen_battle.h"
+
+constexpr int BENCHMARK_WARMUP_FRAMES = 10;
+constexpr float BENCHMARK_FRAME_DT = 1.0F / 60.0F;
+
+namespace {
+struct Replay {
+  ScreenStack::Ptr stack;
+  BattleScreen *battle;
+};
+
+Replay new_replay() {
+  Replay replay{ScreenStack::new_instance(), nullptr};
+
+  auto screen = Screen::new_screen<BattleScreen>(replay.stack);
+  replay.battle = static_cast<BattleScreen *>(screen.get());
+  replay.stack->push_screen(std::move(screen));
+  // Pushes the BattleScreen.
+  replay.stack->update(0.0F);
+  replay.stack->get_shared_data().set_flag(enable_music_flag, false);
+
+  return replay;
+}
+
+/// Returns the CPU time of each frame in milliseconds.
+std::vector<double> replay_frames(Replay &replay, int frames) {
+  std::vector<double> times;
+  times.reserve((std::size_t)frames);
+
+  for (int idx = 0; idx < frames; ++idx) {
+    replay.battle->set_canned_state((float)idx * BENCHMARK_FRAME_DT);
+    double start = GetTime();
+    replay.stack->draw();
+    times.push_back((GetTime() - start) * 1000.0);
+  }
+
+  return times;
+}
+
+/// Waits on all queued rendering by reading back the framebuffer.
+void finish_rendering() { UnloadImage(LoadImageFromScreen()); }
+
+/// "times" must be sorted.
+double percentile(const std::vector<double> &times, double p) {
+  if (times.empty()) {
+    return 0.0;
+  }
+  auto idx = (std::size_t)std::ceil(p * (double)times.size());
+  return times.at(idx > 0 ? idx - 1 : 0);
+}
+}  // namespace
+
+int Benchmark::replay(int frames) {
+  auto replay = new_replay();
+
+  replay_frames(replay, BENCHMARK_WARMUP_FRAMES);
+  finish_rendering();
+
+  auto times = replay_frames(replay, frames);
+  std::sort(times.begin(), times.end());
+
+  double total = 0.0;
+  for (double time : times) {
+    total += time;
+  }
+
+  std::cout << std::format(
+      "{}x{}, {} frames\n"
+      "frame ms: mean {:.3f}, p50 {:.3f}, p90 {:.3f}, p99 {:.3f}, max {:.3f}\n",
+      GetScreenWidth(), GetScreenHeight(), frames, total / (double)frames,
+      percentile(times, 0.50), percentile(times, 0.90),
+      percentile(times, 0.99), times.back());
+
+  return 0;
+}
+
+int Benchmark::ground_shaders(int frames) {
+  auto replay = new_replay();
+
+  for (bool cheap : {false, true}) {
+    replay.stack->get_shared_data().set_flag(cheap_ground_flag, cheap);
+    // Applies the flag.
+    replay.stack->update(0.0F);
+
+    replay_frames(replay, BENCHMARK_WARMUP_FRAMES);
+    finish_rendering();
+
+    double start = GetTime();
+    replay_frames(replay, frames);
+    finish_rendering();
+    double elapsed = GetTime() - start;
+
+    std::cout << std::format("{} ground shader: {:.3f} ms/frame ({} frames)\n",
+                             cheap ? "cheap" : "full",
+                             elapsed * 1000.0 / (double)frames, frames);
+  }
+
+  return 0;
+}
@@ -0,0 +1,16 @@
+#ifndef SEODISPARATE_COM_GANDER_BATTLE_BENCHMARK_H_
+#define SEODISPARATE_COM_GANDER_BATTLE_BENCHMARK_H_
+
+namespace Benchmark {
+/// Replays "frames" frames of a canned BattleScreen camera and sphere path
+/// through the ScreenStack and prints per-frame CPU timing percentiles.
+/// Expects the window to already be initialized (ideally hidden and without
+/// vsync). Returns the process exit code.
+int replay(int frames);
+
+/// Replays "frames" frames with each ground shader variant and prints the
+/// ms/frame of each. Same expectations as replay().
+int ground_shaders(int frames);
+}  // namespace Benchmark
+
+#endif
@@ -13,5 +13,9 @@ constexpr const char *const enable_auto_move_flag = "auto_movement";
 constexpr const char *const enable_music_flag = "music_playing";
 constexpr const char *const toggle_embedded_flag = "toggle_embedded";
 constexpr const char *const combat_camera_flag = "combat_camera";
+constexpr const char *const cheap_ground_flag = "cheap_ground";
+constexpr const char *const frame_times_flag = "frame_times";
+constexpr const char *const dynamic_resolution_flag = "dynamic_resolution";
+constexpr const char *const prewarm_scripting_flag = "prewarm_scripting";
 
 #endif
@@ -0,0 +1,51 @@
+#include "cooked_image.h"
+
+// Standard library includes.
+#include <cstring>
+
+std::optional<CookedImage::Header> CookedImage::read(
+    const ResourceHandler::View &view, ResourceHandler::View *pixels) {
+  auto bytes = view.data();
+  if (bytes.size() < COOKED_IMAGE_HEADER_SIZE ||
+      std::memcmp(bytes.data(), COOKED_IMAGE_MAGIC,
+                  sizeof(COOKED_IMAGE_MAGIC)) != 0) {
+    return std::nullopt;
+  }
+
+  std::uint32_t version;
+  std::memcpy(&version, bytes.data() + sizeof(COOKED_IMAGE_MAGIC),
+              sizeof(version));
+  if (version != COOKED_IMAGE_VERSION) {
+    return std::nullopt;
+  }
+
+  Header header;
+  std::memcpy(&header,
+              bytes.data() + sizeof(COOKED_IMAGE_MAGIC) + sizeof(version),
+              sizeof(header));
+  if (header.width <= 0 || header.height <= 0 || header.mipmaps <= 0) {
+    return std::nullopt;
+  }
+
+  *pixels = view.subview(COOKED_IMAGE_HEADER_SIZE,
+                         bytes.size() - COOKED_IMAGE_HEADER_SIZE);
+  return header;
+}
+
+std::vector<std::byte> CookedImage::write(const Header &header,
+                                          const void *pixels,
+                                          std::size_t size) {
+  static_assert(sizeof(COOKED_IMAGE_MAGIC) + sizeof(COOKED_IMAGE_VERSION) +
+                    sizeof(Header) <=
+                COOKED_IMAGE_HEADER_SIZE);
+
+  std::vector<std::byte> bytes(COOKED_IMAGE_HEADER_SIZE + size, std::byte{0});
+  std::memcpy(bytes.data(), COOKED_IMAGE_MAGIC, sizeof(COOKED_IMAGE_MAGIC));
+  std::memcpy(bytes.data() + sizeof(COOKED_IMAGE_MAGIC), &COOKED_IMAGE_VERSION,
+              sizeof(COOKED_IMAGE_VERSION));
+  std::memcpy(bytes.data() + sizeof(COOKED_IMAGE_MAGIC) +
+                  sizeof(COOKED_IMAGE_VERSION),
+              &header, sizeof(header));
+  std::memcpy(bytes.data() + COOKED_IMAGE_HEADER_SIZE, pixels, size);
+  return bytes;
+}
@@ -0,0 +1,40 @@
+#ifndef SEODISPARATE_COM_GANDER_BATTLE_COOKED_IMAGE_H_
+#define SEODISPARATE_COM_GANDER_BATTLE_COOKED_IMAGE_H_
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Local includes.
+#include "resource_view.h"
+
+/*
+ * An image decoded at pack time, so it can be uploaded straight from the
+ * packfile. Layout, all integers little-endian:
+ *   "GBTX", u32 version, i32 width, i32 height, i32 mipmaps,
+ *   i32 format (raylib's PixelFormat), padding to COOKED_IMAGE_HEADER_SIZE
+ *   Pixel data of every mip level, largest first, as raylib's Image stores it
+ */
+constexpr char COOKED_IMAGE_MAGIC[4] = {'G', 'B', 'T', 'X'};
+constexpr std::uint32_t COOKED_IMAGE_VERSION = 1;
+/// Keeps the pixel data as aligned as the packfile entry.
+constexpr std::size_t COOKED_IMAGE_HEADER_SIZE = 32;
+
+namespace CookedImage {
+struct Header {
+  std::int32_t width;
+  std::int32_t height;
+  std::int32_t mipmaps;
+  std::int32_t format;
+};
+
+/// Returns std::nullopt if "view" is not a cooked image, so it should be
+/// decoded as usual. "pixels" is set to the pixel data otherwise.
+std::optional<Header> read(const ResourceHandler::View &view,
+                           ResourceHandler::View *pixels);
+
+std::vector<std::byte> write(const Header &header, const void *pixels,
+                             std::size_t size);
+}  // namespace CookedImage
+
+#endif
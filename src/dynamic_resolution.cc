@@ -0,0 +1,74 @@
+#include "dynamic_resolution.h"
+
+// Standard library includes.
+#include <algorithm>
+
+DynamicResolution::DynamicResolution()
+    : scale(1.0F),
+      budget_ms(1000.0F / 60.0F),
+      smoothed_ms(1000.0F / 60.0F),
+      stable_ms(0.0F),
+      since_change_ms(0.0F),
+      probe_wait_ms(DYNRES_PROBE_WAIT_MS),
+      last_change_grew(false) {}
+
+bool DynamicResolution::update(float frame_ms) {
+  // Keep one-off hitches (resource loads, etc.) from dominating.
+  frame_ms = std::min(frame_ms, budget_ms * 4.0F);
+  smoothed_ms = smoothed_ms * 0.9F + frame_ms * 0.1F;
+  since_change_ms += frame_ms;
+
+  if (smoothed_ms > budget_ms * DYNRES_OVER_BUDGET) {
+    stable_ms = 0.0F;
+    if (scale > DYNRES_MIN_SCALE &&
+        since_change_ms >= DYNRES_SHRINK_COOLDOWN_MS) {
+      if (last_change_grew && since_change_ms < probe_wait_ms) {
+        // The last probe didn't fit in the budget, back off.
+        probe_wait_ms =
+            std::min(probe_wait_ms * 2.0F, DYNRES_PROBE_WAIT_MAX_MS);
+      }
+      scale = std::max(scale - DYNRES_SCALE_STEP, DYNRES_MIN_SCALE);
+      since_change_ms = 0.0F;
+      last_change_grew = false;
+      // Give the new scale a fresh start.
+      smoothed_ms = budget_ms;
+      return true;
+    }
+    return false;
+  }
+
+  if (smoothed_ms <= budget_ms * DYNRES_UNDER_BUDGET) {
+    stable_ms += frame_ms;
+  } else {
+    stable_ms = 0.0F;
+  }
+
+  if (scale < 1.0F && stable_ms >= probe_wait_ms) {
+    scale = std::min(scale + DYNRES_SCALE_STEP, 1.0F);
+    stable_ms = 0.0F;
+    since_change_ms = 0.0F;
+    last_change_grew = true;
+    return true;
+  }
+
+  return false;
+}
+
+bool DynamicResolution::reset() {
+  bool changed = scale != 1.0F;
+  scale = 1.0F;
+  smoothed_ms = budget_ms;
+  stable_ms = 0.0F;
+  since_change_ms = 0.0F;
+  probe_wait_ms = DYNRES_PROBE_WAIT_MS;
+  last_change_grew = false;
+  return changed;
+}
+
+float DynamicResolution::get_scale() const { return scale; }
+
+void DynamicResolution::set_budget_ms(float budget_ms) {
+  this->budget_ms = budget_ms;
+}
+
+float DynamicResolution::get_budget_ms() const { return budget_ms; }
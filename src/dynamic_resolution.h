@@ -0,0 +1,47 @@
+#ifndef SEODISPARATE_COM_GANDER_BATTLE_DYNAMIC_RESOLUTION_H_
+#define SEODISPARATE_COM_GANDER_BATTLE_DYNAMIC_RESOLUTION_H_
+
+constexpr float DYNRES_MIN_SCALE = 0.5F;
+constexpr float DYNRES_SCALE_STEP = 0.1F;
+/// Shrink when the smoothed frame time exceeds the budget by this factor.
+constexpr float DYNRES_OVER_BUDGET = 1.15F;
+/// Frames within the budget by this factor count as stable.
+constexpr float DYNRES_UNDER_BUDGET = 1.05F;
+/// Minimum time between shrinking steps.
+constexpr float DYNRES_SHRINK_COOLDOWN_MS = 500.0F;
+/// How long frames must be stable before trying to grow.
+constexpr float DYNRES_PROBE_WAIT_MS = 2000.0F;
+constexpr float DYNRES_PROBE_WAIT_MAX_MS = 32000.0F;
+
+/// Picks a render scale from measured frame times, shrinking when over the
+/// frame time budget and probing a larger scale after a stable period.
+///
+/// With vsync or a frame rate limit, frame time alone can't show headroom,
+/// so growing is a probe: if it pushes frames over budget soon after, the
+/// scale shrinks back and the next probe waits twice as long.
+class DynamicResolution {
+ public:
+  DynamicResolution();
+
+  /// Returns true if the scale changed.
+  bool update(float frame_ms);
+
+  /// Sets the scale back to 1.0. Returns true if the scale changed.
+  bool reset();
+
+  float get_scale() const;
+
+  void set_budget_ms(float budget_ms);
+  float get_budget_ms() const;
+
+ private:
+  float scale;
+  float budget_ms;
+  float smoothed_ms;
+  float stable_ms;
+  float since_change_ms;
+  float probe_wait_ms;
+  bool last_change_grew;
+};
+
+#endif
@@ -4,6 +4,4 @@
 extern int call_js_get_canvas_width();
 extern int call_js_get_canvas_height();
 
-extern float call_js_get_random();
-
 #endif
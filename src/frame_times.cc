@@ -0,0 +1,60 @@
+#include "frame_times.h"
+
+// Standard library includes.
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+FrameTimes::FrameTimes() : samples(), next(0), count(0) {}
+
+void FrameTimes::push(float update_ms, float draw_ms, float present_ms) {
+  samples[next] = {update_ms, draw_ms, present_ms};
+  next = (next + 1) % FRAME_TIMES_SIZE;
+  if (count < FRAME_TIMES_SIZE) {
+    ++count;
+  }
+}
+
+std::size_t FrameTimes::size() const { return count; }
+
+float FrameTimes::get(Part part, std::size_t idx) const {
+  const auto &sample =
+      samples[(next + FRAME_TIMES_SIZE - count + idx) % FRAME_TIMES_SIZE];
+  if (part == Part::TOTAL) {
+    return sample[0] + sample[1] + sample[2];
+  }
+  return sample[part];
+}
+
+FrameTimes::Stats FrameTimes::get_stats(Part part) const {
+  if (count == 0) {
+    return Stats{0.0F, 0.0F, 0.0F, 0.0F};
+  }
+
+  std::array<float, FRAME_TIMES_SIZE> sorted;
+  for (std::size_t idx = 0; idx < count; ++idx) {
+    sorted[idx] = get(part, idx);
+  }
+  std::sort(sorted.begin(), sorted.begin() + (long)count);
+
+  auto percentile = [&sorted, this](float p) {
+    auto idx = (std::size_t)std::ceil(p * (float)count);
+    return sorted[idx > 0 ? idx - 1 : 0];
+  };
+
+  return Stats{percentile(0.50F), percentile(0.95F), percentile(0.99F),
+               sorted[count - 1]};
+}
+
+std::optional<FrameTimes::Part> FrameTimes::part_from_name(const char *name) {
+  if (std::strcmp(name, "update") == 0) {
+    return Part::UPDATE;
+  } else if (std::strcmp(name, "draw") == 0) {
+    return Part::DRAW;
+  } else if (std::strcmp(name, "present") == 0) {
+    return Part::PRESENT;
+  } else if (std::strcmp(name, "total") == 0) {
+    return Part::TOTAL;
+  }
+  return std::nullopt;
+}
@@ -0,0 +1,43 @@
+#ifndef SEODISPARATE_COM_GANDER_BATTLE_FRAME_TIMES_H_
+#define SEODISPARATE_COM_GANDER_BATTLE_FRAME_TIMES_H_
+
+#include <array>
+#include <cstddef>
+#include <optional>
+
+constexpr std::size_t FRAME_TIMES_SIZE = 240;
+
+/// Fixed-size ring buffer of the most recent frames' timings in milliseconds.
+class FrameTimes {
+ public:
+  enum Part { UPDATE, DRAW, PRESENT, TOTAL };
+
+  struct Stats {
+    float p50;
+    float p95;
+    float p99;
+    float max;
+  };
+
+  FrameTimes();
+
+  void push(float update_ms, float draw_ms, float present_ms);
+
+  /// Number of frames recorded, at most FRAME_TIMES_SIZE.
+  std::size_t size() const;
+  /// idx 0 is the oldest recorded frame, "size() - 1" the newest.
+  float get(Part part, std::size_t idx) const;
+
+  Stats get_stats(Part part) const;
+
+  /// Valid names are "update", "draw", "present", and "total".
+  static std::optional<Part> part_from_name(const char *name);
+
+ private:
+  // Each sample holds UPDATE, DRAW, and PRESENT.
+  std::array<std::array<float, 3>, FRAME_TIMES_SIZE> samples;
+  std::size_t next;
+  std::size_t count;
+};
+
+#endif
@@ -4,16 +4,26 @@
 #include <emscripten/html5.h>
 
 #include "ems.h"
+#else
+// Standard library includes.
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <optional>
 #endif
 
 // Third party includes.
 #include <raylib.h>
 
 // Local includes.
+#include "benchmark.h"
 #include "constants.h"
 #include "screen.h"
 #include "screen_battle.h"
 #include "screen_debug.h"
+#include "startup_trace.h"
 
 #ifdef __EMSCRIPTEN__
 ScreenStack *global_screen_stack_ptr = nullptr;
@@ -30,13 +40,88 @@ EM_BOOL resize_event_callback(int event_type, const EmscriptenUiEvent *event,
 void main_loop_update(void *ud) {
   global_screen_stack_ptr->update(GetFrameTime());
   global_screen_stack_ptr->draw();
+  if (!StartupTrace::is_finished()) {
+    StartupTrace::finish();
+  }
+}
 }
+#else
+namespace {
+void print_usage() {
+  std::cout << "Usage: GanderBattle [--benchmark <frames>] "
+               "[--benchmark-ground <frames>] [--software-gl] "
+               "[--startup-trace <file.json>] "
+               "[--exit-after-first-frame] [--seed <n>]\n";
+}
+
+/// Parses all of "arg" as a decimal number, returns false if any of it isn't.
+template <typename T>
+bool parse_number(const char *arg, T *value) {
+  const char *end = arg + std::strlen(arg);
+  auto [ptr, ec] = std::from_chars(arg, end, *value);
+  return ec == std::errc() && ptr == end;
 }
+}  // namespace
 #endif
 
 int main(int argc, char **argv) {
-  InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Gander Battle");
-  InitAudioDevice();
+#ifndef __EMSCRIPTEN__
+  int benchmark_frames = 0;
+  int ground_benchmark_frames = 0;
+  bool report_startup = false;
+  bool exit_after_first_frame = false;
+  std::optional<std::uint64_t> seed;
+  for (int idx = 1; idx < argc; ++idx) {
+    if (std::strcmp(argv[idx], "--benchmark") == 0 && idx + 1 < argc) {
+      if (!parse_number(argv[++idx], &benchmark_frames) ||
+          benchmark_frames <= 0) {
+        print_usage();
+        return 1;
+      }
+    } else if (std::strcmp(argv[idx], "--benchmark-ground") == 0 &&
+               idx + 1 < argc) {
+      if (!parse_number(argv[++idx], &ground_benchmark_frames) ||
+          ground_benchmark_frames <= 0) {
+        print_usage();
+        return 1;
+      }
+    } else if (std::strcmp(argv[idx], "--software-gl") == 0) {
+      // Have Mesa render with llvmpipe, for machines without a GPU.
+#ifndef _WIN32
+      setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+#endif
+    } else if (std::strcmp(argv[idx], "--startup-trace") == 0 &&
+               idx + 1 < argc) {
+      StartupTrace::set_json_path(argv[++idx]);
+      report_startup = true;
+    } else if (std::strcmp(argv[idx], "--exit-after-first-frame") == 0) {
+      exit_after_first_frame = true;
+      report_startup = true;
+    } else if (std::strcmp(argv[idx], "--seed") == 0 && idx + 1 < argc) {
+      if (!parse_number(argv[++idx], &seed.emplace())) {
+        print_usage();
+        return 1;
+      }
+    } else {
+      print_usage();
+      return 1;
+    }
+  }
+
+  if (benchmark_frames > 0 || ground_benchmark_frames > 0) {
+    // Hidden window, and no vsync as FLAG_VSYNC_HINT is not set.
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+  }
+#endif
+
+  {
+    StartupTrace::Scope scope("InitWindow");
+    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Gander Battle");
+  }
+  {
+    StartupTrace::Scope scope("InitAudioDevice");
+    InitAudioDevice();
+  }
 
 #ifdef NDEBUG
   SetTraceLogLevel(LOG_WARNING);
@@ -54,16 +139,63 @@ int main(int argc, char **argv) {
   emscripten_set_main_loop_arg(main_loop_update, nullptr, 0, 1);
 #else
 
+  if (benchmark_frames > 0 || ground_benchmark_frames > 0) {
+    int ret = 0;
+    if (benchmark_frames > 0) {
+      ret = Benchmark::replay(benchmark_frames);
+    }
+    if (ret == 0 && ground_benchmark_frames > 0) {
+      ret = Benchmark::ground_shaders(ground_benchmark_frames);
+    }
+    CloseAudioDevice();
+    CloseWindow();
+    return ret;
+  }
+
   SetTargetFPS(60);
 
   {
-    auto stack = ScreenStack::new_instance();
-    stack->push_constructing_screen<BattleScreen>();
-    stack->set_overlay_screen<DebugScreen>();
+    ScreenStack::Ptr stack;
+    {
+      StartupTrace::Scope scope("ScreenStack");
+      stack = ScreenStack::new_instance();
+      if (seed.has_value()) {
+        // Before the first update constructs the screens, which split it.
+        stack->get_shared_data().seed_rng(*seed);
+      }
+#ifndef NDEBUG
+      TraceLog(LOG_INFO, "RNG seed: %llu",
+               (unsigned long long)stack->get_shared_data().rng_seed);
+#endif
+      BattleScreen::prefetch(stack->get_resource_loader());
+      stack->push_constructing_screen<BattleScreen>();
+      stack->set_overlay_screen<DebugScreen>();
+    }
 
     while (!WindowShouldClose()) {
-      stack->update(GetFrameTime());
-      stack->draw();
+      if (StartupTrace::is_finished()) {
+        stack->update(GetFrameTime());
+        stack->draw();
+        continue;
+      }
+
+      {
+        // Constructs the screens.
+        StartupTrace::Scope scope("First update");
+        stack->update(GetFrameTime());
+      }
+      {
+        StartupTrace::Scope scope("First draw");
+        stack->draw();
+      }
+      double first_frame_ms = StartupTrace::finish();
+      if (report_startup) {
+        std::cout << "First frame presented after " << first_frame_ms
+                  << " ms\n";
+      }
+      if (exit_after_first_frame) {
+        break;
+      }
     }
   }
 #endif
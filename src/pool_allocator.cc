@@ -0,0 +1,232 @@
+#include "pool_allocator.h"
+
+// Standard library includes.
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+static_assert(POOL_ALIGNMENT % alignof(std::max_align_t) == 0);
+static_assert(POOL_ARENA_SIZE % POOL_ALIGNMENT == 0);
+static_assert(std::is_sorted(POOL_SIZE_CLASSES_LUA.begin(),
+                             POOL_SIZE_CLASSES_LUA.end()));
+static_assert(std::is_sorted(POOL_SIZE_CLASSES_DUK.begin(),
+                             POOL_SIZE_CLASSES_DUK.end()));
+
+PoolAllocator::PoolAllocator(std::span<const std::size_t> size_classes)
+    : size_classes(size_classes),
+      free_lists(size_classes.size(), nullptr),
+      arenas(),
+      arena_next(nullptr),
+      arena_end(nullptr),
+      in_use(0),
+      peak(0),
+      limit(0),
+      allocs_frame(0),
+      allocs_last_frame(0),
+      allocs_total(0) {}
+
+PoolAllocator::~PoolAllocator() {
+  for (auto *arena : arenas) {
+    std::free(arena);
+  }
+}
+
+void *PoolAllocator::allocate(std::size_t size) {
+  std::size_t size_idx = size_class(size);
+  std::size_t rounded = block_size(size);
+  if (limit != 0 && in_use + rounded > limit) {
+    return nullptr;
+  }
+
+  void *ptr;
+  if (size_idx == size_classes.size()) {
+    ptr = std::malloc(size);
+  } else if (free_lists[size_idx]) {
+    ptr = free_lists[size_idx];
+    free_lists[size_idx] = free_lists[size_idx]->next;
+  } else {
+    if ((std::size_t)(arena_end - arena_next) < rounded) {
+      // The rest of the current arena is left unused, it is at most the
+      // largest size class.
+      auto *arena = static_cast<std::byte *>(std::malloc(POOL_ARENA_SIZE));
+      if (!arena) {
+        return nullptr;
+      }
+      arenas.push_back(arena);
+      arena_next = arena;
+      arena_end = arena + POOL_ARENA_SIZE;
+    }
+    ptr = arena_next;
+    arena_next += rounded;
+  }
+
+  if (ptr) {
+    in_use += rounded;
+    peak = std::max(peak, in_use);
+    ++allocs_frame;
+    ++allocs_total;
+  }
+  return ptr;
+}
+
+void PoolAllocator::deallocate(void *ptr, std::size_t size) {
+  if (!ptr) {
+    return;
+  }
+
+  std::size_t size_idx = size_class(size);
+  in_use -= block_size(size);
+  if (size_idx == size_classes.size()) {
+    std::free(ptr);
+  } else {
+    auto *block = static_cast<FreeBlock *>(ptr);
+    block->next = free_lists[size_idx];
+    free_lists[size_idx] = block;
+  }
+}
+
+void *PoolAllocator::reallocate(void *ptr, std::size_t old_size,
+                                std::size_t new_size) {
+  if (!ptr) {
+    return allocate(new_size);
+  }
+
+  std::size_t old_idx = size_class(old_size);
+  std::size_t new_idx = size_class(new_size);
+  if (old_idx == new_idx && old_idx != size_classes.size()) {
+    // Same block size.
+    return ptr;
+  } else if (old_idx == size_classes.size() &&
+             new_idx == size_classes.size()) {
+    if (limit != 0 && new_size > old_size &&
+        in_use + (new_size - old_size) > limit) {
+      return nullptr;
+    }
+    void *new_ptr = std::realloc(ptr, new_size);
+    if (new_ptr) {
+      in_use = in_use - old_size + new_size;
+      peak = std::max(peak, in_use);
+    } else if (new_size < old_size) {
+      // Keep the larger block rather than fail a shrink.
+      return ptr;
+    }
+    return new_ptr;
+  }
+
+  void *new_ptr = allocate(new_size);
+  if (!new_ptr) {
+    if (new_size < old_size) {
+      // Over the limit, or out of memory. The old block is large enough.
+      return ptr;
+    }
+    return nullptr;
+  }
+  std::memcpy(new_ptr, ptr, std::min(old_size, new_size));
+  deallocate(ptr, old_size);
+  return new_ptr;
+}
+
+void PoolAllocator::set_limit(std::size_t limit) { this->limit = limit; }
+
+void PoolAllocator::new_frame() {
+  allocs_last_frame = allocs_frame;
+  allocs_frame = 0;
+}
+
+void PoolAllocator::release_unused() {
+  if (in_use != 0) {
+    return;
+  }
+  for (auto *arena : arenas) {
+    std::free(arena);
+  }
+  arenas.clear();
+  std::fill(free_lists.begin(), free_lists.end(), nullptr);
+  arena_next = nullptr;
+  arena_end = nullptr;
+}
+
+PoolAllocator::Stats PoolAllocator::get_stats() const {
+  return Stats{in_use,
+               peak,
+               arenas.size() * POOL_ARENA_SIZE,
+               allocs_last_frame,
+               allocs_total,
+               limit};
+}
+
+void *PoolAllocator::lua_alloc(void *ud, void *ptr, std::size_t osize,
+                               std::size_t nsize) {
+  auto *allocator = static_cast<PoolAllocator *>(ud);
+  if (nsize == 0) {
+    allocator->deallocate(ptr, osize);
+    return nullptr;
+  }
+  // When "ptr" is NULL, "osize" is the kind of object, not a size.
+  return allocator->reallocate(ptr, ptr ? osize : 0, nsize);
+}
+
+void *PoolAllocator::duk_alloc(void *udata, std::size_t size) {
+  auto *allocator = static_cast<PoolAllocator *>(udata);
+  auto *block = static_cast<std::byte *>(
+      allocator->allocate(size + POOL_DUK_HEADER_SIZE));
+  if (!block) {
+    return nullptr;
+  }
+  std::memcpy(block, &size, sizeof(size));
+  return block + POOL_DUK_HEADER_SIZE;
+}
+
+void *PoolAllocator::duk_realloc(void *udata, void *ptr, std::size_t size) {
+  if (!ptr) {
+    return duk_alloc(udata, size);
+  } else if (size == 0) {
+    duk_free(udata, ptr);
+    return nullptr;
+  }
+
+  auto *allocator = static_cast<PoolAllocator *>(udata);
+  auto *block = static_cast<std::byte *>(ptr) - POOL_DUK_HEADER_SIZE;
+  std::size_t old_size;
+  std::memcpy(&old_size, block, sizeof(old_size));
+
+  std::size_t old_idx = allocator->size_class(old_size + POOL_DUK_HEADER_SIZE);
+  if (old_idx != allocator->size_classes.size() &&
+      old_idx == allocator->size_class(size + POOL_DUK_HEADER_SIZE)) {
+    // Same block size.
+    std::memcpy(block, &size, sizeof(size));
+    return ptr;
+  }
+
+  // Not reallocate(), as the header must keep the size of the block kept.
+  void *new_ptr = duk_alloc(udata, size);
+  if (!new_ptr) {
+    // A shrink can't fail, the old block is large enough.
+    return size < old_size ? ptr : nullptr;
+  }
+  std::memcpy(new_ptr, ptr, std::min(old_size, size));
+  allocator->deallocate(block, old_size + POOL_DUK_HEADER_SIZE);
+  return new_ptr;
+}
+
+void PoolAllocator::duk_free(void *udata, void *ptr) {
+  if (!ptr) {
+    return;
+  }
+  auto *allocator = static_cast<PoolAllocator *>(udata);
+  auto *block = static_cast<std::byte *>(ptr) - POOL_DUK_HEADER_SIZE;
+  std::size_t size;
+  std::memcpy(&size, block, sizeof(size));
+  allocator->deallocate(block, size + POOL_DUK_HEADER_SIZE);
+}
+
+std::size_t PoolAllocator::size_class(std::size_t size) const {
+  return (std::size_t)(std::lower_bound(size_classes.begin(),
+                                        size_classes.end(), size) -
+                       size_classes.begin());
+}
+
+std::size_t PoolAllocator::block_size(std::size_t size) const {
+  std::size_t size_idx = size_class(size);
+  return size_idx == size_classes.size() ? size : size_classes[size_idx];
+}
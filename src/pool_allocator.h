@@ -0,0 +1,107 @@
+#ifndef SEODISPARATE_COM_GANDER_BATTLE_POOL_ALLOCATOR_H_
+#define SEODISPARATE_COM_GANDER_BATTLE_POOL_ALLOCATOR_H_
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+/*
+ * Block sizes served from the arenas, larger ones go to std::malloc. Each
+ * must be a multiple of POOL_ALIGNMENT, in ascending order.
+ */
+/// Lua strings and closures are small, tables start around 56 bytes.
+constexpr std::array<std::size_t, 12> POOL_SIZE_CLASSES_LUA = {
+    16, 32, 48, 64, 80, 96, 128, 192, 256, 384, 512, 1024};
+/// Duktape blocks carry POOL_DUK_HEADER_SIZE, and its objects and strings
+/// mostly fall within 48 to 160 bytes with it.
+constexpr std::array<std::size_t, 12> POOL_SIZE_CLASSES_DUK = {
+    32, 48, 64, 80, 96, 112, 128, 160, 192, 256, 512, 1024};
+constexpr std::size_t POOL_ALIGNMENT = 16;
+constexpr std::size_t POOL_ARENA_SIZE = 64 * 1024;
+/// Duktape's free doesn't pass the size, so each block is prefixed with it.
+constexpr std::size_t POOL_DUK_HEADER_SIZE = POOL_ALIGNMENT;
+
+/// Size-class allocator for a scripting engine's heap. Small blocks come from
+/// per-class free lists carved out of arenas, so the engine's churn of small
+/// objects doesn't go through malloc. Not thread safe, each engine state owns
+/// one.
+///
+/// Sizes are passed back on deallocate(), as Lua's allocator interface does.
+class PoolAllocator {
+ public:
+  struct Stats {
+    /// Block sizes rounded up to their size class.
+    std::size_t in_use;
+    std::size_t peak;
+    /// Held by arenas, whether in use or not.
+    std::size_t reserved;
+    std::size_t allocs_last_frame;
+    std::size_t allocs_total;
+    /// 0 if unlimited.
+    std::size_t limit;
+  };
+
+  explicit PoolAllocator(std::span<const std::size_t> size_classes);
+  ~PoolAllocator();
+
+  // No copy.
+  PoolAllocator(const PoolAllocator &) = delete;
+  PoolAllocator &operator=(const PoolAllocator &) = delete;
+
+  // No move, engine states keep a pointer to this.
+  PoolAllocator(PoolAllocator &&) = delete;
+  PoolAllocator &operator=(PoolAllocator &&) = delete;
+
+  /// Returns nullptr if out of memory or over the limit.
+  void *allocate(std::size_t size);
+  void deallocate(void *ptr, std::size_t size);
+  /// Shrinking never fails. Returns nullptr on failure, leaving "ptr" as is.
+  void *reallocate(void *ptr, std::size_t old_size, std::size_t new_size);
+
+  /// Allocations past "limit" bytes in use fail, 0 for unlimited. Lowering it
+  /// below what is in use only fails later allocations.
+  void set_limit(std::size_t limit);
+
+  /// Call once per frame, to count allocations per frame.
+  void new_frame();
+
+  /// Frees the arenas if nothing is in use, e.g. after the engine state was
+  /// closed.
+  void release_unused();
+
+  Stats get_stats() const;
+
+  /// The Lua allocator function (lua_Alloc), with a PoolAllocator as "ud".
+  static void *lua_alloc(void *ud, void *ptr, std::size_t osize,
+                         std::size_t nsize);
+
+  /// Duktape's allocation functions, with a PoolAllocator as "udata".
+  static void *duk_alloc(void *udata, std::size_t size);
+  static void *duk_realloc(void *udata, void *ptr, std::size_t size);
+  static void duk_free(void *udata, void *ptr);
+
+ private:
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  /// size_classes.size() if too large for the arenas.
+  std::size_t size_class(std::size_t size) const;
+  std::size_t block_size(std::size_t size) const;
+
+  std::span<const std::size_t> size_classes;
+  std::vector<FreeBlock *> free_lists;
+  std::vector<std::byte *> arenas;
+  /// Unused end of the newest arena.
+  std::byte *arena_next;
+  std::byte *arena_end;
+  std::size_t in_use;
+  std::size_t peak;
+  std::size_t limit;
+  std::size_t allocs_frame;
+  std::size_t allocs_last_frame;
+  std::size_t allocs_total;
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include "resource_archive.h"
+
+// Standard library includes.
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+static_assert(std::endian::native == std::endian::little,
+              "The packfile is read and written in native byte order.");
+
+namespace {
+template <typename T>
+bool read_value(std::span<const std::byte> bytes, std::size_t &offset,
+                T &value) {
+  if (bytes.size() - offset < sizeof(T)) {
+    return false;
+  }
+  std::memcpy(&value, bytes.data() + offset, sizeof(T));
+  offset += sizeof(T);
+  return true;
+}
+
+template <typename T>
+void write_value(std::ofstream &ofs, T value) {
+  ofs.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+std::uint64_t align_up(std::uint64_t value) {
+  return (value + ARCHIVE_ALIGNMENT - 1) / ARCHIVE_ALIGNMENT *
+         ARCHIVE_ALIGNMENT;
+}
+}  // namespace
+
+ResourceArchive::ResourceArchive() : mapping(), index() {}
+
+bool ResourceArchive::open(const char *filename) {
+  mapping = ResourceHandler::map_file(filename);
+  index.clear();
+
+  auto bytes = mapping.data();
+  std::size_t offset = 0;
+  char magic[4];
+  std::uint32_t version;
+  std::uint32_t count;
+  if (bytes.size() < sizeof(magic)) {
+    mapping = ResourceHandler::View();
+    return false;
+  }
+  std::memcpy(magic, bytes.data(), sizeof(magic));
+  offset += sizeof(magic);
+  if (std::memcmp(magic, ARCHIVE_MAGIC, sizeof(magic)) != 0 ||
+      !read_value(bytes, offset, version) || version != ARCHIVE_VERSION ||
+      !read_value(bytes, offset, count)) {
+    mapping = ResourceHandler::View();
+    return false;
+  }
+
+  index.reserve(count);
+  for (std::uint32_t idx = 0; idx < count; ++idx) {
+    Entry entry;
+    std::uint32_t name_size;
+    std::uint32_t type_size;
+    if (!read_value(bytes, offset, entry.offset) ||
+        !read_value(bytes, offset, entry.size) ||
+        !read_value(bytes, offset, entry.source_hash) ||
+        !read_value(bytes, offset, name_size) ||
+        !read_value(bytes, offset, type_size) ||
+        bytes.size() - offset < (std::size_t)name_size + type_size ||
+        entry.offset > bytes.size() ||
+        entry.size > bytes.size() - entry.offset) {
+      mapping = ResourceHandler::View();
+      index.clear();
+      return false;
+    }
+    auto chars = reinterpret_cast<const char *>(bytes.data()) + offset;
+    entry.file_type = std::string_view(chars + name_size, type_size);
+    index.emplace(std::string(chars, name_size), entry);
+    offset += (std::size_t)name_size + type_size;
+  }
+
+  return true;
+}
+
+bool ResourceArchive::is_open() const { return !mapping.empty(); }
+
+ResourceHandler::View ResourceArchive::get(std::string_view name) const {
+  if (auto iter = index.find(name); iter != index.end()) {
+    return mapping.subview(iter->second.offset, iter->second.size)
+        .with_file_type(iter->second.file_type);
+  }
+  return ResourceHandler::View();
+}
+
+std::optional<ResourceArchive::Entry> ResourceArchive::get_entry(
+    std::string_view name) const {
+  if (auto iter = index.find(name); iter != index.end()) {
+    return iter->second;
+  }
+  return std::nullopt;
+}
+
+std::size_t ResourceArchive::size() const { return index.size(); }
+
+std::vector<std::string> ResourceArchive::get_names() const {
+  std::vector<std::string> names;
+  names.reserve(index.size());
+  for (const auto &[name, entry] : index) {
+    names.push_back(name);
+  }
+  return names;
+}
+
+bool ResourceArchive::write(const char *filename,
+                            const std::vector<Input> &entries) {
+  std::string temp_filename = std::string(filename) + ".tmp";
+  std::ofstream ofs(temp_filename,
+                    std::ios_base::binary | std::ios_base::trunc);
+  if (!ofs.good()) {
+    return false;
+  }
+
+  std::uint64_t header_size = sizeof(ARCHIVE_MAGIC) + sizeof(std::uint32_t) * 2;
+  for (const auto &[name, view, source_hash] : entries) {
+    header_size += sizeof(std::uint64_t) * 3 + sizeof(std::uint32_t) * 2 +
+                   name.size() + view.file_type().size();
+  }
+
+  ofs.write(ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+  write_value(ofs, ARCHIVE_VERSION);
+  write_value(ofs, (std::uint32_t)entries.size());
+
+  std::uint64_t offset = align_up(header_size);
+  for (const auto &[name, view, source_hash] : entries) {
+    write_value(ofs, offset);
+    write_value(ofs, (std::uint64_t)view.data().size());
+    write_value(ofs, source_hash);
+    write_value(ofs, (std::uint32_t)name.size());
+    write_value(ofs, (std::uint32_t)view.file_type().size());
+    ofs.write(name.data(), (std::streamsize)name.size());
+    ofs.write(view.file_type().data(),
+              (std::streamsize)view.file_type().size());
+    offset = align_up(offset + view.data().size());
+  }
+
+  std::uint64_t written = header_size;
+  for (const auto &[name, view, source_hash] : entries) {
+    static const char padding[ARCHIVE_ALIGNMENT] = {};
+    ofs.write(padding, (std::streamsize)(align_up(written) - written));
+    written = align_up(written);
+
+    ofs.write(reinterpret_cast<const char *>(view.data().data()),
+              (std::streamsize)view.data().size());
+    written += view.data().size();
+  }
+
+  ofs.close();
+  if (ofs.fail()) {
+    std::filesystem::remove(temp_filename);
+    return false;
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temp_filename, filename, error);
+  return !error;
+}
+
+std::uint64_t ResourceArchive::hash_bytes(std::span<const std::byte> bytes,
+                                          std::uint64_t seed) {
+  constexpr std::uint64_t PRIME = 0x9E3779B97F4A7C15ULL;
+  std::uint64_t hash = seed ^ (bytes.size() * PRIME);
+  std::size_t idx = 0;
+  for (; idx + 8 <= bytes.size(); idx += 8) {
+    std::uint64_t word;
+    std::memcpy(&word, bytes.data() + idx, sizeof(word));
+    hash = (hash ^ word) * PRIME;
+    hash ^= hash >> 29;
+  }
+  for (; idx < bytes.size(); ++idx) {
+    hash = (hash ^ (std::uint64_t)bytes[idx]) * PRIME;
+  }
+  hash ^= hash >> 32;
+  return hash * PRIME;
+}
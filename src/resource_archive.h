@@ -0,0 +1,82 @@
+#ifndef SEODISPARATE_COM_GANDER_BATTLE_RESOURCE_ARCHIVE_H_
+#define SEODISPARATE_COM_GANDER_BATTLE_RESOURCE_ARCHIVE_H_
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Local includes.
+#include "resource_view.h"
+
+/*
+ * Packfile layout, all integers little-endian:
+ *   "GBPK", u32 version, u32 entry count
+ *   Per entry: u64 offset, u64 size, u64 source hash, u32 name length,
+ *     u32 file type length, name bytes, file type bytes (see
+ *     View::file_type())
+ *   Entry data, each starting at a multiple of ARCHIVE_ALIGNMENT
+ */
+constexpr char ARCHIVE_MAGIC[4] = {'G', 'B', 'P', 'K'};
+constexpr std::uint32_t ARCHIVE_VERSION = 3;
+constexpr std::uint64_t ARCHIVE_ALIGNMENT = 16;
+
+/// A packfile that is mapped and indexed once, after which lookups are a hash
+/// map access that return views into the mapping.
+class ResourceArchive {
+ public:
+  struct Entry {
+    std::uint64_t offset;
+    std::uint64_t size;
+    /// Set by the packer, to tell if the entry is stale.
+    std::uint64_t source_hash;
+    /// Points into the mapping.
+    std::string_view file_type;
+  };
+
+  struct Input {
+    /// Path under "res/", with "/" separators.
+    std::string name;
+    ResourceHandler::View view;
+    std::uint64_t source_hash;
+  };
+
+  ResourceArchive();
+
+  /// Returns false if the file is missing or is not a valid packfile.
+  bool open(const char *filename);
+  bool is_open() const;
+
+  /// Returns an empty View if "name" is not in the archive. The View's
+  /// file_type() is set if the packer converted the resource.
+  ResourceHandler::View get(std::string_view name) const;
+
+  std::optional<Entry> get_entry(std::string_view name) const;
+
+  std::size_t size() const;
+  std::vector<std::string> get_names() const;
+
+  /// Writes to a temporary file first, so "filename" may be open (and mapped)
+  /// while writing, for reusing its entries.
+  static bool write(const char *filename, const std::vector<Input> &entries);
+
+  /// A fast 64-bit hash for spotting changed inputs, not for security.
+  static std::uint64_t hash_bytes(std::span<const std::byte> bytes,
+                                  std::uint64_t seed);
+
+ private:
+  struct NameHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view name) const {
+      return std::hash<std::string_view>{}(name);
+    }
+  };
+
+  ResourceHandler::View mapping;
+  std::unordered_map<std::string, Entry, NameHash, std::equal_to<> > index;
+};
+
+#endif
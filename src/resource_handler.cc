@@ -1,65 +1,63 @@
 #include "resource_handler.h"
 
 // Standard library includes.
-#include <cstring>
-#include <filesystem>
-#include <fstream>
+#include <string_view>
 
 // Third-party includes.
-#ifndef __EMSCRIPTEN__
-#ifdef SEODISPARATE_RESOURCE_PACKER_AVAILABLE
-#include <ResourcePacker.hpp>
-#endif
-#endif
 #include <raylib.h>
 
-std::vector<char> ResourceHandler::load(const char *filename) {
-  std::vector<char> data;
-  do {
+// Local includes.
+#include "resource_archive.h"
+
+namespace {
+/// Opened and indexed on first use, so later lookups never reopen "data".
+const ResourceArchive &get_archive() {
+  static const ResourceArchive archive = [] {
+    ResourceArchive archive;
+    archive.open("data");
+    return archive;
+  }();
+  return archive;
+}
+}  // namespace
+
+ResourceHandler::View ResourceHandler::load_view(const char *filename) {
 #ifndef NDEBUG
-    TraceLog(LOG_INFO, "Attempting to load \"%s\"...", filename);
+  TraceLog(LOG_INFO, "Attempting to load \"%s\"...", filename);
 #endif
-    std::ifstream ifs(filename);
-    if (!ifs.good()) {
-      break;
-    }
-
-    ifs.seekg(0, std::ios_base::end);
-    auto size = ifs.tellg();
-    data.resize((unsigned long)size);
-
-    ifs.seekg(0);
-    ifs.read(data.data(), size);
-    if (!ifs.fail()) {
+  if (auto view = map_file(filename); !view.empty()) {
 #ifndef NDEBUG
-      TraceLog(LOG_INFO, "Loaded \"%s\".", filename);
+    TraceLog(LOG_INFO, "Loaded \"%s\".", filename);
 #endif
-      return data;
-    }
-  } while (false);
+    return view;
+  }
 
-#ifndef __EMSCRIPTEN__
-#ifdef SEODISPARATE_RESOURCE_PACKER_AVAILABLE
+  if (const auto &archive = get_archive(); archive.is_open()) {
 #ifndef NDEBUG
-  TraceLog(LOG_INFO, "Attempting to load \"%s\" from packfile...", filename);
+    TraceLog(LOG_INFO, "Attempting to load \"%s\" from packfile...", filename);
 #endif
-  if (RP::checkIfPackfile("data")) {
-    std::unique_ptr<char[]> data_ptr{};
-    std::uint64_t size;
-    if (RP::getFileData(data_ptr, size, std::string("data"),
-                        std::filesystem::path(filename).filename().string())) {
-      data.resize(size);
-      std::memcpy(data.data(), data_ptr.get(), size);
+    // Entries are named by their path under "res/".
+    std::string_view name = filename;
+    if (name.starts_with("res/")) {
+      name.remove_prefix(4);
+    }
+    if (auto view = archive.get(name); !view.empty()) {
 #ifndef NDEBUG
       TraceLog(LOG_INFO, "Loaded \"%s\" from packfile.", filename);
 #endif
-      return data;
+      return view;
     }
   }
-#endif  // RESOURCE_PACKER_AVAILABLE
-#endif  // Not __EMSCRIPTEN__
 
   TraceLog(LOG_WARNING, "Failed to load resource: %s", filename);
 
-  return data;
+  return View();
+}
+
+std::vector<char> ResourceHandler::load(const char *filename) {
+  auto view = load_view(filename);
+  auto bytes = view.data();
+  return std::vector<char>(reinterpret_cast<const char *>(bytes.data()),
+                           reinterpret_cast<const char *>(bytes.data()) +
+                               bytes.size());
 }
@@ -3,8 +3,16 @@
 
 #include <vector>
 
+// Local includes.
+#include "resource_view.h"
+
 namespace ResourceHandler {
+/// Tries the loose file first, then the "data" packfile. Returns an empty
+/// View on failure.
+View load_view(const char *filename);
+
+/// Copies the resource's bytes, prefer load_view().
 std::vector<char> load(const char *filename);
-}
+}  // namespace ResourceHandler
 
 #endif
@@ -0,0 +1,156 @@
+#include "resource_loader.h"
+
+// Standard library includes.
+#include <algorithm>
+#include <chrono>
+
+namespace {
+bool is_ready(const ResourceLoader::Future &future) {
+  return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+}  // namespace
+
+ResourceLoader::ResourceLoader()
+    : mutex(),
+      condition(),
+      jobs(),
+      loads(),
+      callbacks(),
+      threads(),
+      next_order(0),
+      stopping(false) {
+#ifndef __EMSCRIPTEN__
+  for (unsigned int idx = 0; idx < RESOURCE_LOADER_THREADS; ++idx) {
+    threads.emplace_back(&ResourceLoader::worker, this);
+  }
+#endif
+}
+
+ResourceLoader::~ResourceLoader() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  condition.notify_all();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  // Queued jobs that never started break their promises here.
+}
+
+ResourceLoader::Future ResourceLoader::request(const std::string &name,
+                                               Priority priority) {
+  std::lock_guard<std::mutex> lock(mutex);
+  return enqueue(name, priority, true);
+}
+
+std::vector<ResourceLoader::Future> ResourceLoader::request_all(
+    const std::vector<std::string> &names, Priority priority) {
+  std::vector<Future> futures;
+  futures.reserve(names.size());
+  for (const auto &name : names) {
+    futures.push_back(request(name, priority));
+  }
+  return futures;
+}
+
+void ResourceLoader::request(const std::string &name, Priority priority,
+                             Callback callback,
+                             std::weak_ptr<const void> alive) {
+  callbacks.push_back(PendingCallback{name, request(name, priority),
+                                      std::move(callback), std::move(alive)});
+}
+
+void ResourceLoader::prefetch(const std::vector<std::string> &names,
+                              Priority priority) {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (const auto &name : names) {
+    enqueue(name, priority, false);
+  }
+}
+
+void ResourceLoader::poll() {
+  // Callbacks may request more, so don't iterate "callbacks" directly.
+  std::vector<PendingCallback> ready;
+  std::erase_if(callbacks, [&ready](PendingCallback &pending) {
+    if (is_ready(pending.future)) {
+      ready.push_back(std::move(pending));
+      return true;
+    }
+    return false;
+  });
+
+  for (auto &pending : ready) {
+    if (!pending.alive.expired()) {
+      pending.callback(pending.name, pending.future.get());
+    }
+  }
+}
+
+void ResourceLoader::clear_prefetched() {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::erase_if(loads, [](const auto &entry) {
+    return is_ready(entry.second.future);
+  });
+}
+
+ResourceLoader::Future ResourceLoader::enqueue(const std::string &name,
+                                               Priority priority, bool take) {
+  Future future;
+  if (auto iter = loads.find(name); iter != loads.end()) {
+    for (auto &job : jobs) {
+      if (job.name == name) {
+        job.priority = std::max(job.priority, priority);
+        break;
+      }
+    }
+    future = iter->second.future;
+    iter->second.taken = iter->second.taken || take;
+  } else {
+    std::promise<ResourceHandler::View> promise;
+    future = promise.get_future().share();
+    loads.emplace(name, Load{future, take});
+
+    if (threads.empty()) {
+      promise.set_value(ResourceHandler::load_view(name.c_str()));
+    } else {
+      jobs.push_back(Job{name, std::move(promise), next_order++, priority});
+      condition.notify_one();
+    }
+  }
+
+  if (take && is_ready(future)) {
+    // Later requests load it again.
+    loads.erase(name);
+  }
+  return future;
+}
+
+void ResourceLoader::worker() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      condition.wait(lock, [this] { return stopping || !jobs.empty(); });
+      if (stopping) {
+        return;
+      }
+
+      auto iter = std::max_element(
+          jobs.begin(), jobs.end(), [](const Job &a, const Job &b) {
+            return a.priority < b.priority ||
+                   (a.priority == b.priority && a.order > b.order);
+          });
+      job = std::move(*iter);
+      jobs.erase(iter);
+    }
+
+    job.promise.set_value(ResourceHandler::load_view(job.name.c_str()));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (auto iter = loads.find(job.name);
+        iter != loads.end() && iter->second.taken) {
+      loads.erase(iter);
+    }
+  }
+}
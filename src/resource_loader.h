@@ -0,0 +1,106 @@
+#ifndef SEODISPARATE_COM_GANDER_BATTLE_RESOURCE_LOADER_H_
+#define SEODISPARATE_COM_GANDER_BATTLE_RESOURCE_LOADER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Local includes.
+#include "resource_handler.h"
+
+/// Number of I/O threads. Emscripten builds have no threads and load inside
+/// request() instead.
+constexpr unsigned int RESOURCE_LOADER_THREADS = 2;
+
+/// Loads resources through ResourceHandler::load_view() on a small pool of
+/// I/O threads, so screens can prefetch assets without stalling the frame.
+///
+/// Loads that finish before anyone asks for them are kept until the first
+/// request() of that name, so prefetched assets are not loaded twice.
+class ResourceLoader {
+ public:
+  /// Queued loads of higher priority start first, equal priority in FIFO
+  /// order.
+  enum Priority { LOW, NORMAL, HIGH };
+
+  using Future = std::shared_future<ResourceHandler::View>;
+  using Callback =
+      std::function<void(const std::string &name, ResourceHandler::View)>;
+
+  ResourceLoader();
+  ~ResourceLoader();
+
+  // No copy.
+  ResourceLoader(const ResourceLoader &) = delete;
+  ResourceLoader &operator=(const ResourceLoader &) = delete;
+
+  // No move, the I/O threads refer to this.
+  ResourceLoader(ResourceLoader &&) = delete;
+  ResourceLoader &operator=(ResourceLoader &&) = delete;
+
+  /// The View is empty if the resource failed to load. Requesting a name that
+  /// is already queued returns the same future, raising its priority if
+  /// needed.
+  Future request(const std::string &name, Priority priority = NORMAL);
+  std::vector<Future> request_all(const std::vector<std::string> &names,
+                                  Priority priority = NORMAL);
+  /// "callback" is called from poll() on the render thread, so it may upload
+  /// to the GPU. It is skipped if "alive" has expired by then.
+  void request(const std::string &name, Priority priority, Callback callback,
+               std::weak_ptr<const void> alive);
+
+  /// Same as request(), but does not take the result, keeping it for a later
+  /// request().
+  void prefetch(const std::vector<std::string> &names,
+                Priority priority = LOW);
+
+  /// Runs callbacks of finished loads. Call once per frame.
+  void poll();
+
+  /// Drops finished loads that were never requested.
+  void clear_prefetched();
+
+ private:
+  struct Job {
+    std::string name;
+    std::promise<ResourceHandler::View> promise;
+    std::uint64_t order;
+    Priority priority;
+  };
+
+  struct Load {
+    Future future;
+    /// Set once request()ed, so the entry is dropped when the load finishes.
+    bool taken;
+  };
+
+  struct PendingCallback {
+    std::string name;
+    Future future;
+    Callback callback;
+    std::weak_ptr<const void> alive;
+  };
+
+  /// Must be called with "mutex" held.
+  Future enqueue(const std::string &name, Priority priority, bool take);
+  void worker();
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::vector<Job> jobs;
+  /// Queued, loading, or finished but not yet requested.
+  std::unordered_map<std::string, Load> loads;
+  std::vector<PendingCallback> callbacks;
+  std::vector<std::thread> threads;
+  std::uint64_t next_order;
+  bool stopping;
+};
+
+#endif
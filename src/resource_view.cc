@@ -0,0 +1,98 @@
+#include "resource_view.h"
+
+// Standard library includes.
+#include <fstream>
+
+#if !defined(__EMSCRIPTEN__) && !defined(_WIN32)
+#define SEODISPARATE_RESOURCE_VIEW_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+ResourceHandler::View::View() : bytes(), type(), owner() {}
+
+ResourceHandler::View::View(std::span<const std::byte> bytes,
+                            std::shared_ptr<const void> owner)
+    : bytes(bytes), type(), owner(std::move(owner)) {}
+
+std::span<const std::byte> ResourceHandler::View::data() const {
+  return bytes;
+}
+
+bool ResourceHandler::View::empty() const { return bytes.empty(); }
+
+const unsigned char *ResourceHandler::View::u_data() const {
+  return reinterpret_cast<const unsigned char *>(bytes.data());
+}
+
+int ResourceHandler::View::i_size() const { return (int)bytes.size(); }
+
+ResourceHandler::View ResourceHandler::View::subview(std::size_t offset,
+                                                     std::size_t size) const {
+  if (offset > bytes.size() || size > bytes.size() - offset) {
+    return View();
+  }
+  return View(bytes.subspan(offset, size), owner);
+}
+
+std::string_view ResourceHandler::View::file_type() const { return type; }
+
+ResourceHandler::View ResourceHandler::View::with_file_type(
+    std::string_view type) const {
+  View view = *this;
+  view.type = type;
+  return view;
+}
+
+#ifdef SEODISPARATE_RESOURCE_VIEW_USE_MMAP
+ResourceHandler::View ResourceHandler::map_file(const char *filename) {
+  int fd = open(filename, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return View();
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+    close(fd);
+    return View();
+  }
+  auto size = (std::size_t)file_stat.st_size;
+
+  void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the fd is closed.
+  close(fd);
+  if (addr == MAP_FAILED) {
+    return View();
+  }
+
+  return View(
+      std::span<const std::byte>(static_cast<const std::byte *>(addr), size),
+      std::shared_ptr<const void>(addr, [size](const void *ptr) {
+        munmap(const_cast<void *>(ptr), size);
+      }));
+}
+#else
+ResourceHandler::View ResourceHandler::map_file(const char *filename) {
+  std::ifstream ifs(filename, std::ios_base::binary);
+  if (!ifs.good()) {
+    return View();
+  }
+
+  ifs.seekg(0, std::ios_base::end);
+  auto size = ifs.tellg();
+  if (size <= 0) {
+    return View();
+  }
+
+  std::shared_ptr<std::byte[]> data(new std::byte[(std::size_t)size]);
+  ifs.seekg(0);
+  ifs.read(reinterpret_cast<char *>(data.get()), size);
+  if (ifs.fail()) {
+    return View();
+  }
+
+  return View(std::span<const std::byte>(data.get(), (std::size_t)size), data);
+}
+#endif
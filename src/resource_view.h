@@ -0,0 +1,50 @@
+#ifndef SEODISPARATE_COM_GANDER_BATTLE_RESOURCE_VIEW_H_
+#define SEODISPARATE_COM_GANDER_BATTLE_RESOURCE_VIEW_H_
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string_view>
+
+// Note that this and resource_archive.cc are also built into the ResourcePack
+// tool, so must not depend on raylib.
+
+namespace ResourceHandler {
+/// Read-only bytes of a loaded resource. The bytes stay valid while this View
+/// or any copy of it exists.
+class View {
+ public:
+  View();
+  View(std::span<const std::byte> bytes, std::shared_ptr<const void> owner);
+
+  std::span<const std::byte> data() const;
+  bool empty() const;
+
+  /// For raylib's "FromMemory" functions.
+  const unsigned char *u_data() const;
+  int i_size() const;
+
+  /// Returns a View of part of this one, sharing its owner. Returns an empty
+  /// View if out of bounds.
+  View subview(std::size_t offset, std::size_t size) const;
+
+  /// The file type (like ".qoa") the packer converted the resource to, or
+  /// empty if it is in its original format.
+  std::string_view file_type() const;
+  /// "type" must live as long as the owner, e.g. a literal or part of the
+  /// owned bytes.
+  View with_file_type(std::string_view type) const;
+
+ private:
+  std::span<const std::byte> bytes;
+  std::string_view type;
+  /// Unmaps or frees the bytes once the last View referring to them is gone.
+  std::shared_ptr<const void> owner;
+};
+
+/// Memory-maps the file where supported, otherwise reads it. Returns an empty
+/// View on failure or if the file is empty.
+View map_file(const char *filename);
+}  // namespace ResourceHandler
+
+#endif
@@ -0,0 +1,29 @@
+#include "rng.h"
+
+Rng::Rng(std::uint64_t seed, std::uint64_t stream)
+    : state(0), increment((stream << 1U) | 1U) {
+  // As pcg32_srandom_r() of the reference implementation.
+  next();
+  state += seed;
+  next();
+}
+
+void Rng::fill(std::span<std::uint32_t> values) {
+  for (auto &value : values) {
+    value = next();
+  }
+}
+
+void Rng::fill(std::span<float> values) {
+  for (auto &value : values) {
+    value = next_float();
+  }
+}
+
+Rng Rng::split() {
+  // Drawn in order, as "(next() << 32) | next()" may evaluate either first.
+  std::uint32_t words[4];
+  fill(words);
+  return Rng(((std::uint64_t)words[0] << 32U) | words[1],
+             ((std::uint64_t)words[2] << 32U) | words[3]);
+}
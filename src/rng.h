@@ -0,0 +1,46 @@
+#ifndef SEODISPARATE_COM_GANDER_BATTLE_RNG_H_
+#define SEODISPARATE_COM_GANDER_BATTLE_RNG_H_
+
+// Standard library includes.
+#include <cstdint>
+#include <span>
+
+/// PCG32 (XSH RR), a small and fast generator whose sequence depends only on
+/// integer arithmetic, so native and web builds produce the same values for
+/// the same seed.
+///
+/// Each seed has 2^63 streams, independent sequences picked by "stream", so
+/// simulations sharing a seed each get one of their own.
+class Rng {
+ public:
+  explicit Rng(std::uint64_t seed, std::uint64_t stream = 0);
+
+  std::uint32_t next() {
+    std::uint64_t old_state = state;
+    state = old_state * 6364136223846793005ULL + increment;
+    auto xorshifted =
+        (std::uint32_t)(((old_state >> 18U) ^ old_state) >> 27U);
+    auto rotation = (std::uint32_t)(old_state >> 59U);
+    return (xorshifted >> rotation) | (xorshifted << ((-rotation) & 31U));
+  }
+
+  /// In [0, 1), from the top 24 bits of next() so every value is exact.
+  float next_float() {
+    return (float)(next() >> 8U) * (1.0F / 16777216.0F);
+  }
+
+  /// Same as calling next() or next_float() for each of "values" in order.
+  void fill(std::span<std::uint32_t> values);
+  void fill(std::span<float> values);
+
+  /// A new generator, on a stream picked by this one, so each split is its own
+  /// sequence and this one continues independently.
+  Rng split();
+
+ private:
+  std::uint64_t state;
+  /// Selects the stream, always odd.
+  std::uint64_t increment;
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include "screen.h"
 
 // standard library includes
+#include <algorithm>
 #include <cassert>
 #ifndef NDEBUG
 #include <iostream>
@@ -11,6 +12,7 @@
 #include <raylib.h>
 
 // Local includes.
+#include "constants.h"
 #include "screen_blank.h"
 #include "screen_debug.h"
 
@@ -76,9 +78,21 @@ ScreenStack::Ptr ScreenStack::new_instance() {
 ScreenStack::~ScreenStack() {
   UnloadRenderTexture(*render_texture);
   render_texture.reset();
+  if (native_texture) {
+    UnloadRenderTexture(*native_texture);
+    native_texture.reset();
+  }
 }
 
 void ScreenStack::update(float dt) {
+  double start = GetTime();
+  update_dynamic_resolution(dt);
+  resource_loader->poll();
+  update_screens(dt);
+  update_ms = (float)((GetTime() - start) * 1000.0);
+}
+
+void ScreenStack::update_screens(float dt) {
   handle_pending_actions();
 
   bool resized = IsWindowResized();
@@ -98,7 +112,7 @@ void ScreenStack::update(float dt) {
 #endif  // NDEBUG
       set_overlay_screen<DebugScreen>();
     }
-    update(dt);
+    update_screens(dt);
     return;
   }
   if (!overlay_screen || overlay_screen->update(dt, resized)) {
@@ -108,19 +122,42 @@ void ScreenStack::update(float dt) {
 }
 
 void ScreenStack::draw() {
+  double start = GetTime();
+
   for (decltype(stack.size()) idx = 0;
        idx < stack.size() && stack.at(idx)->draw(render_texture.get()); ++idx) {
   }
+
+  RenderTexture *target = render_texture.get();
+  if (native_texture) {
+    // Upscale, so that the overlay is drawn at native resolution.
+    BeginTextureMode(*native_texture);
+    DrawTexturePro(render_texture->texture,
+                   Rectangle{0, 0, (float)render_texture->texture.width,
+                             (float)-render_texture->texture.height},
+                   Rectangle{0, 0, (float)native_texture->texture.width,
+                             (float)native_texture->texture.height},
+                   {0, 0}, 0.0F, WHITE);
+    EndTextureMode();
+    target = native_texture.get();
+  }
+
   if (overlay_screen) {
-    overlay_screen->draw(render_texture.get());
+    overlay_screen->draw(target);
   }
 
+  double drawn = GetTime();
+
   BeginDrawing();
   DrawTextureRec(
-      render_texture->texture,
+      target->texture,
       Rectangle{0, 0, (float)GetScreenWidth(), (float)-GetScreenHeight()},
       {0, 0}, WHITE);
+  // Also waits on the frame rate limit, if any.
   EndDrawing();
+
+  shared_data.frame_times.push(update_ms, (float)((drawn - start) * 1000.0),
+                               (float)((GetTime() - drawn) * 1000.0));
 }
 
 void ScreenStack::push_screen(Screen::Ptr &&screen) {
@@ -137,19 +174,42 @@ void ScreenStack::clear_screens() {
 
 void ScreenStack::reset_render_texture() {
   UnloadRenderTexture(*render_texture);
+  if (native_texture) {
+    UnloadRenderTexture(*native_texture);
+    native_texture.reset();
+  }
 
-  *render_texture = LoadRenderTexture(GetScreenWidth(), GetScreenHeight());
+  float scale = dynamic_resolution.get_scale();
+  if (scale < 1.0F) {
+    *render_texture =
+        LoadRenderTexture(std::max((int)((float)GetScreenWidth() * scale), 1),
+                          std::max((int)((float)GetScreenHeight() * scale), 1));
+    SetTextureFilter(render_texture->texture, TEXTURE_FILTER_BILINEAR);
+    native_texture = std::make_unique<RenderTexture>(
+        LoadRenderTexture(GetScreenWidth(), GetScreenHeight()));
+  } else {
+    *render_texture = LoadRenderTexture(GetScreenWidth(), GetScreenHeight());
+  }
 }
 
 SharedData &ScreenStack::get_shared_data() { return shared_data; }
 
 const SharedData &ScreenStack::get_shared_data() const { return shared_data; }
 
+ResourceLoader &ScreenStack::get_resource_loader() { return *resource_loader; }
+
 bool ScreenStack::is_overlay_screen_set() const { return (bool)overlay_screen; }
 
 ScreenStack::ScreenStack()
-    : render_texture(new RenderTexture), self_weak(), stack(), actions() {
+    : render_texture(new RenderTexture),
+      self_weak(),
+      stack(),
+      actions(),
+      dynamic_resolution(),
+      resource_loader(std::make_unique<ResourceLoader>()),
+      update_ms(0.0F) {
   *render_texture = LoadRenderTexture(GetScreenWidth(), GetScreenHeight());
+  shared_data.init_flag(dynamic_resolution_flag, false);
 }
 
 void ScreenStack::unset_overlay_screen() {
@@ -157,7 +217,7 @@ void ScreenStack::unset_overlay_screen() {
 }
 
 std::list<std::string> ScreenStack::get_known_flags() const {
-  std::list<std::string> flag_names;
+  std::list<std::string> flag_names{dynamic_resolution_flag};
   if (overlay_screen) {
     auto overlay_flags = overlay_screen->get_known_flags();
     flag_names.insert(flag_names.end(), overlay_flags.cbegin(),
@@ -172,6 +232,24 @@ std::list<std::string> ScreenStack::get_known_flags() const {
   return flag_names;
 }
 
+void ScreenStack::update_dynamic_resolution(float dt) {
+  bool changed;
+  if (auto flag = shared_data.get_flag(dynamic_resolution_flag);
+      flag.has_value() && flag.value()) {
+    changed = dynamic_resolution.update(dt * 1000.0F);
+  } else {
+    changed = dynamic_resolution.reset();
+  }
+
+  if (changed) {
+#ifndef NDEBUG
+    std::clog << "Render scale is now " << dynamic_resolution.get_scale()
+              << ".\n";
+#endif  // NDEBUG
+    reset_render_texture();
+  }
+}
+
 void ScreenStack::handle_pending_actions() {
   while (!actions.empty()) {
     switch (actions.front().action) {
@@ -9,6 +9,8 @@
 #include <vector>
 
 // Local includes.
+#include "dynamic_resolution.h"
+#include "resource_loader.h"
 #include "shared_data.h"
 
 // Forward declarations.
@@ -120,6 +122,8 @@ class ScreenStack {
   SharedData &get_shared_data();
   const SharedData &get_shared_data() const;
 
+  ResourceLoader &get_resource_loader();
+
   bool is_overlay_screen_set() const;
 
   template <typename SubScreen>
@@ -136,13 +140,22 @@ class ScreenStack {
   ScreenStack();
 
   void handle_pending_actions();
+  void update_screens(float dt);
+  void update_dynamic_resolution(float dt);
 
   Screen::Ptr overlay_screen;
+  /// Screens draw to this, which is scaled by dynamic_resolution.
   std::unique_ptr<RenderTexture> render_texture;
+  /// Native resolution, holds the upscaled render_texture and the overlay.
+  /// Only loaded while the scale is below 1.0.
+  std::unique_ptr<RenderTexture> native_texture;
   Weak self_weak;
   std::vector<Screen::Ptr> stack;
   std::deque<PendingAction> actions;
   SharedData shared_data;
+  DynamicResolution dynamic_resolution;
+  std::unique_ptr<ResourceLoader> resource_loader;
+  float update_ms;
 };
 
 template <typename SubScreen>
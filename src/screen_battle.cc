@@ -3,7 +3,11 @@
 #include "sc_sacd.h"
 
 // Standard library includes.
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <numbers>
+#include <string>
 
 #ifndef NDEBUG
 #include <iostream>
@@ -11,42 +15,57 @@
 
 // Local includes.
 #include "constants.h"
-#include "ems.h"
+#include "cooked_image.h"
 #include "resource_handler.h"
+#include "startup_trace.h"
+
+// Third party includes.
+#include <raymath.h>
+
+using namespace std::string_literals;
+
+static const char *BATTLE_MUSIC_RESOURCE = "res/GanderBattle_00.mp3";
+static const char *BLUE_NOISE_RESOURCE = "res/blue_noise_256x256.png";
 
 static const char *BATTLE_SCREEN_GROUND_SHADER_VS =
-    // Default vertex shader from Raylib.
+    // Default vertex shader from Raylib, with per-instance transforms.
     "#version 100                       \n"
     "precision mediump float;           \n"  // Precision required for OpenGL
                                              // ES2 (WebGL) (on some browsers)
     "attribute vec3 vertexPosition;     \n"
     "attribute vec2 vertexTexCoord;     \n"
     "attribute vec4 vertexColor;        \n"
+    "attribute mat4 instanceTransform;  \n"
     "varying vec2 fragTexCoord;         \n"
     "varying vec4 fragColor;            \n"
+    "varying vec2 fragCenter;           \n"
     "uniform mat4 mvp;                  \n"
     "void main()                        \n"
     "{                                  \n"
     "    fragTexCoord = vertexTexCoord; \n"
     "    fragColor = vertexColor;       \n"
-    "    gl_Position = mvp*vec4(vertexPosition, 1.0); \n"
+    // The instance's translation is the center of its ground circle.
+    "    fragCenter = instanceTransform[3].xz; \n"
+    "    gl_Position = mvp*instanceTransform*vec4(vertexPosition, 1.0); \n"
     "}                                  \n";
 ;
+// "#version" and "#define GROUND_CIRCLES_MAX" are prepended when loaded.
 static const char *BATTLE_SCREEN_GROUND_SHADER_FS =
-    "#version 100\n"
     "precision mediump float;\n"
     "// Input vertex attributes (from vertex shader)\n"
     "varying vec2 fragTexCoord;\n"
     "varying vec4 fragColor;\n"
+    "varying vec2 fragCenter;\n"
     "// Input uniform values\n"
     "uniform sampler2D texture0;\n"
     "uniform vec4 colDiffuse;\n"
     "uniform float ground_scale;\n"
-    "uniform vec2 pos;\n"
-    "uniform vec2 other_pos;\n"
+    "uniform vec2 positions[GROUND_CIRCLES_MAX];\n"
+    "uniform int positions_count;\n"
     "uniform float radius;\n"
     "uniform float ground_size;\n"
     "void main() {\n"
+    "vec2 pos = fragCenter;\n"
     // Scale by ground_scale. Smaller the scale, the larger the texture.
     "vec2 offset = (fragTexCoord + pos / ground_size) * ground_scale;\n"
     // Ensure texture wraps-around.
@@ -67,11 +86,22 @@ static const char *BATTLE_SCREEN_GROUND_SHADER_FS =
     // Ensure a "circle" of the ground is visible.
     "vec2 diff = fragTexCoord - vec2(0.5, 0.5);\n"
     "float diff_length = length(diff);\n"
-    "vec2 pos_diff = (other_pos - pos) / ground_size;\n"
     "if (diff_length > 0.45) {\n"
     "  texelColor.a = 0.0;\n"
     "} else if (diff_length > 0.35) {\n"
-    "  if (distance(diff, pos_diff) > 0.35) {\n"
+    // Don't fade where another circle's inner area overlaps. This circle's
+    // own entry is always farther than 0.35 here, so it needs no skipping.
+    "  bool overlapped = false;\n"
+    "  for (int idx = 0; idx < GROUND_CIRCLES_MAX; ++idx) {\n"
+    "    if (idx >= positions_count) {\n"
+    "      break;\n"
+    "    }\n"
+    "    vec2 pos_diff = (positions[idx] - pos) / ground_size;\n"
+    "    if (distance(diff, pos_diff) <= 0.35) {\n"
+    "      overlapped = true;\n"
+    "    }\n"
+    "  }\n"
+    "  if (!overlapped) {\n"
     "    float value = 1.0 - (diff_length - 0.35) * 10.0;\n"
     "    texelColor.r = texelColor.r * value;\n"
     "    texelColor.g = texelColor.g * value;\n"
@@ -82,17 +112,143 @@ static const char *BATTLE_SCREEN_GROUND_SHADER_FS =
     "gl_FragColor = texelColor;\n"
     "}\n";
 
+// Lower cost variant of BATTLE_SCREEN_GROUND_SHADER_FS. Wrap-around is left
+// to repeat sampling of texture0, and the circle's edge falloff is read from
+// the precomputed mask in texture1 (see gen_ground_falloff_image()).
+static const char *BATTLE_SCREEN_GROUND_SHADER_CHEAP_FS =
+    "precision mediump float;\n"
+    "// Input vertex attributes (from vertex shader)\n"
+    "varying vec2 fragTexCoord;\n"
+    "varying vec4 fragColor;\n"
+    "varying vec2 fragCenter;\n"
+    "// Input uniform values\n"
+    "uniform sampler2D texture0;\n"
+    "uniform sampler2D texture1;\n"
+    "uniform vec4 colDiffuse;\n"
+    "uniform float ground_scale;\n"
+    "uniform vec2 positions[GROUND_CIRCLES_MAX];\n"
+    "uniform int positions_count;\n"
+    "uniform float ground_size;\n"
+    "void main() {\n"
+    "vec2 offset = (fragTexCoord + fragCenter / ground_size) * ground_scale;\n"
+    "vec4 texelColor = texture2D(texture0, offset)*colDiffuse*fragColor;\n"
+    "texelColor = texelColor * 0.7 + vec4(0.3, 0.3, 0.3, 0.3);\n"
+    "float mask = texture2D(texture1, fragTexCoord).r;\n"
+    // 1.0 if within the inner area (radius 0.35) of any circle.
+    "float overlapped = 0.0;\n"
+    "vec2 diff = fragTexCoord - vec2(0.5, 0.5);\n"
+    "for (int idx = 0; idx < GROUND_CIRCLES_MAX; ++idx) {\n"
+    "  if (idx >= positions_count) {\n"
+    "    break;\n"
+    "  }\n"
+    "  vec2 other_diff = diff - (positions[idx] - fragCenter) / ground_size;\n"
+    "  overlapped = max(overlapped, step(dot(other_diff, other_diff), "
+    "0.1225));\n"
+    "}\n"
+    "gl_FragColor = texelColor * (step(0.004, mask) * max(mask, overlapped));\n"
+    "}\n";
+
+/// Loads a ground shader with the given fragment shader body and sets its
+/// constant uniforms. Returns the location of its "positions" uniform.
+static int load_ground_shader(Shader *shader, const char *fs_body,
+                              float ground_scale) {
+  std::string fs_source = "#version 100\n#define GROUND_CIRCLES_MAX "s +
+                          std::to_string(GROUND_CIRCLES_MAX) + "\n"s +
+                          fs_body;
+  *shader =
+      LoadShaderFromMemory(BATTLE_SCREEN_GROUND_SHADER_VS, fs_source.c_str());
+#if RAYLIB_VERSION_MAJOR >= 6
+  shader->locs[SHADER_LOC_VERTEX_INSTANCETRANSFORM] =
+      GetShaderLocationAttrib(*shader, "instanceTransform");
+#else
+  shader->locs[SHADER_LOC_VERTEX_INSTANCE_TX] =
+      GetShaderLocationAttrib(*shader, "instanceTransform");
+#endif
+  SetShaderValue(*shader, GetShaderLocation(*shader, "ground_scale"),
+                 &ground_scale, SHADER_UNIFORM_FLOAT);
+
+  int count = GROUND_CIRCLES;
+  SetShaderValue(*shader, GetShaderLocation(*shader, "positions_count"),
+                 &count, SHADER_UNIFORM_INT);
+
+  float temp = GROUND_PLANE_SIZE_F / 2.2F;
+  SetShaderValue(*shader, GetShaderLocation(*shader, "radius"), &temp,
+                 SHADER_UNIFORM_FLOAT);
+
+  temp = GROUND_PLANE_SIZE_F;
+  SetShaderValue(*shader, GetShaderLocation(*shader, "ground_size"), &temp,
+                 SHADER_UNIFORM_FLOAT);
+
+  return GetShaderLocation(*shader, "positions");
+}
+
+/// Radial falloff of a ground circle: opaque up to 0.35 from the center, fading
+/// out linearly until 0.45 (in texture coordinates).
+static Image gen_ground_falloff_image(int size) {
+  Image image = GenImageColor(size, size, BLACK);
+  Color *pixels = (Color *)image.data;
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      float u = ((float)x + 0.5F) / (float)size - 0.5F;
+      float v = ((float)y + 0.5F) / (float)size - 0.5F;
+      float dist = std::sqrt(u * u + v * v);
+      float value;
+      if (dist > 0.45F) {
+        value = 0.0F;
+      } else if (dist > 0.35F) {
+        value = 1.0F - (dist - 0.35F) * 10.0F;
+      } else {
+        value = 1.0F;
+      }
+      unsigned char c = (unsigned char)(value * 255.0F);
+      pixels[y * size + x] = Color{c, c, c, 255};
+    }
+  }
+  return image;
+}
+
+/// Uploads a cooked image straight from "view" (see cooked_image.h), or
+/// decodes "view" as "file_type" (e.g. ".png") if the packer didn't cook it.
+static Texture2D load_texture(const ResourceHandler::View &view,
+                              const char *file_type) {
+  ResourceHandler::View pixels;
+  if (auto header = CookedImage::read(view, &pixels); header.has_value()) {
+    std::size_t size = 0;
+    for (int level = 0, width = header->width, height = header->height;
+         level < header->mipmaps; ++level) {
+      size += (std::size_t)GetPixelDataSize(width, height, header->format);
+      width = std::max(width / 2, 1);
+      height = std::max(height / 2, 1);
+    }
+    if (pixels.data().size() < size) {
+      TraceLog(LOG_WARNING, "Cooked image is truncated!");
+      return Texture2D{};
+    }
+
+    // Only read during the upload, so the pixels can stay in the packfile.
+    Image image{const_cast<std::byte *>(pixels.data().data()), header->width,
+                header->height, header->mipmaps, header->format};
+    return LoadTextureFromImage(image);
+  }
+
+  auto image = LoadImageFromMemory(file_type, view.u_data(), view.i_size());
+  auto texture = LoadTextureFromImage(image);
+  UnloadImage(image);
+  return texture;
+}
+
 BattleScreen::BattleScreen(std::weak_ptr<ScreenStack> stack)
     : Screen(stack),
       camera_orbit_timer(0.0F),
-      sphere{{-1.0F, 0.21F, 0.0F, 0.2F}, {0.0F, 0.21F, 0.0F, 0.2F}},
-      sphere_vel{{0.0F, 0.0F, 0.0F}, {0.0F, 0.0F, 0.0F}},
-      sphere_acc{{0.0F, 0.0F, 0.0F}, {0.0F, 0.0F, 0.0F}},
-      sphere_touch_point{{0.0F, 0.0F, 0.0F}, {0.0F, 0.0F, 0.0F}},
-      floor_box{0.0F, -1.0F, 0.0F, 10.0F, 2.0F, 10.0F},
+      sim(),
+      rng(stack.lock()->get_shared_data().rng.split()),
+      battle_music(),
       ground_pos{0.0F, 0.0F, 0.0F, 0.0F},
       prev_auto_move_flag_value(false),
-      prev_music_play_value(true) {
+      prev_music_play_value(true),
+      prev_cheap_ground_value(false) {
+  StartupTrace::Scope scope("BattleScreen");
+
   camera.up.x = 0.0F;
   camera.up.y = 1.0F;
   camera.up.z = 0.0F;
@@ -109,12 +265,23 @@ BattleScreen::BattleScreen(std::weak_ptr<ScreenStack> stack)
 
   camera.projection = CAMERA_PERSPECTIVE;
 
+  // Both load in parallel, or are already loaded if prefetch() was called.
+  auto &loader = stack.lock()->get_resource_loader();
+  auto music_future =
+      loader.request(BATTLE_MUSIC_RESOURCE, ResourceLoader::HIGH);
+  auto blue_noise_future =
+      loader.request(BLUE_NOISE_RESOURCE, ResourceLoader::HIGH);
+
   {
-    music_data = ResourceHandler::load("res/GanderBattle_00.mp3");
+    StartupTrace::Scope music_scope("Music");
+    music_data = music_future.get();
     if (!music_data.empty()) {
+      // The packer may have transcoded it, see ResourcePack's --music-qoa.
+      std::string file_type = music_data.file_type().empty()
+                                  ? ".mp3"s
+                                  : std::string(music_data.file_type());
       battle_music = LoadMusicStreamFromMemory(
-          ".mp3", (const unsigned char *)music_data.data(),
-          (int)music_data.size());
+          file_type.c_str(), music_data.u_data(), music_data.i_size());
       if (IsMusicValid(battle_music)) {
 #ifndef NDEBUG
         TraceLog(LOG_INFO, "battle_music is ready, playing...");
@@ -133,49 +300,50 @@ BattleScreen::BattleScreen(std::weak_ptr<ScreenStack> stack)
     }
   }
 
-  ground_model = LoadModelFromMesh(
-      GenMeshPlane(GROUND_PLANE_SIZE, GROUND_PLANE_SIZE, 1, 1));
+  {
+    StartupTrace::Scope mesh_scope("Ground mesh");
+    ground_model = LoadModelFromMesh(
+        GenMeshPlane(GROUND_PLANE_SIZE, GROUND_PLANE_SIZE, 1, 1));
+  }
 
   {
-    auto blue_noise_data = ResourceHandler::load("res/blue_noise_256x256.png");
+    StartupTrace::Scope texture_scope("Blue noise texture");
+    auto blue_noise_data = blue_noise_future.get();
 
-    if (blue_noise_data.size() != 0) {
-      auto image = LoadImageFromMemory(
-          ".png", (const unsigned char *)blue_noise_data.data(),
-          (int)blue_noise_data.size());
+    if (!blue_noise_data.empty()) {
       ground_model.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture =
-          LoadTextureFromImage(image);
-      UnloadImage(image);
+          load_texture(blue_noise_data, ".png");
+      // The cheap ground shader relies on repeat sampling for wrap-around.
+      SetTextureWrap(
+          ground_model.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture,
+          TEXTURE_WRAP_REPEAT);
     }
   }
 
-  ground_shader = LoadShaderFromMemory(BATTLE_SCREEN_GROUND_SHADER_VS,
-                                       BATTLE_SCREEN_GROUND_SHADER_FS);
-  ground_shader_scale_idx = GetShaderLocation(ground_shader, "ground_scale");
   ground_scale = SHADER_GROUND_SCALE;
-  SetShaderValue(ground_shader, ground_shader_scale_idx, &ground_scale,
-                 SHADER_UNIFORM_FLOAT);
-
-  ground_shader_pos_idx = GetShaderLocation(ground_shader, "pos");
-  SetShaderValue(ground_shader, ground_shader_pos_idx, ground_pos,
-                 SHADER_UNIFORM_VEC2);
-
-  ground_shader_other_pos_idx = GetShaderLocation(ground_shader, "other_pos");
-  SetShaderValue(ground_shader, ground_shader_pos_idx, ground_pos + 2,
-                 SHADER_UNIFORM_VEC2);
-
-  ground_shader_radius_idx = GetShaderLocation(ground_shader, "radius");
-  float temp = GROUND_PLANE_SIZE_F / 2.2F;
-  SetShaderValue(ground_shader, ground_shader_radius_idx, &temp,
-                 SHADER_UNIFORM_FLOAT);
+  {
+    StartupTrace::Scope shader_scope("Ground shaders");
+    ground_shader_positions_idx = load_ground_shader(
+        &ground_shader, BATTLE_SCREEN_GROUND_SHADER_FS, ground_scale);
+    ground_shader_cheap_positions_idx =
+        load_ground_shader(&ground_shader_cheap,
+                           BATTLE_SCREEN_GROUND_SHADER_CHEAP_FS, ground_scale);
+  }
 
-  ground_shader_ground_size_idx =
-      GetShaderLocation(ground_shader, "ground_size");
-  temp = GROUND_PLANE_SIZE_F;
-  SetShaderValue(ground_shader, ground_shader_ground_size_idx, &temp,
-                 SHADER_UNIFORM_FLOAT);
+  {
+    StartupTrace::Scope falloff_scope("Ground falloff texture");
+    // Bound to "texture1" of the cheap ground shader.
+    auto image = gen_ground_falloff_image(GROUND_FALLOFF_SIZE);
+    Texture2D falloff = LoadTextureFromImage(image);
+    UnloadImage(image);
+    SetTextureFilter(falloff, TEXTURE_FILTER_BILINEAR);
+    SetTextureWrap(falloff, TEXTURE_WRAP_CLAMP);
+    ground_model.materials[0].maps[MATERIAL_MAP_SPECULAR].texture = falloff;
+  }
 
   ground_model.materials[0].shader = ground_shader;
+  ground_model.materials[0].maps[MATERIAL_MAP_DIFFUSE].color =
+      Color{0, 128, 0, 255};
 
 #ifndef NDEBUG
   TraceLog(LOG_INFO, "Shader is ready: %s",
@@ -185,8 +353,23 @@ BattleScreen::BattleScreen(std::weak_ptr<ScreenStack> stack)
 }
 
 BattleScreen::~BattleScreen() {
-  UnloadModel(ground_model);
+  if (IsMusicValid(battle_music)) {
+    // Stop streaming before music_data is unmapped.
+    UnloadMusicStream(battle_music);
+  }
+  // UnloadModel() only frees the meshes and material maps, not the shaders or
+  // textures they refer to.
   UnloadShader(ground_shader);
+  UnloadShader(ground_shader_cheap);
+  UnloadTexture(ground_model.materials[0].maps[MATERIAL_MAP_SPECULAR].texture);
+  UnloadModel(ground_model);
+  if (auto ss = stack.lock()) {
+    ss->get_shared_data().combatants.clear();
+  }
+}
+
+void BattleScreen::prefetch(ResourceLoader &loader) {
+  loader.prefetch({BATTLE_MUSIC_RESOURCE, BLUE_NOISE_RESOURCE});
 }
 
 bool BattleScreen::update(float dt, bool screen_resized) {
@@ -205,8 +388,8 @@ bool BattleScreen::update(float dt, bool screen_resized) {
   float rot_magnitude;
 
   if (combat_camera_enabled) {
-    x_diff = sphere[1].x - sphere[0].x;
-    z_diff = sphere[1].z - sphere[0].z;
+    x_diff = sim.sphere[1].x - sim.sphere[0].x;
+    z_diff = sim.sphere[1].z - sim.sphere[0].z;
 
     x_diff /= 2.0F;
     z_diff /= 2.0F;
@@ -224,47 +407,11 @@ bool BattleScreen::update(float dt, bool screen_resized) {
       flag_opt.has_value() && prev_auto_move_flag_value != flag_opt.value()) {
     prev_auto_move_flag_value = flag_opt.value();
     if (flag_opt.value()) {
-      sphere_vel[0].x =
-          (call_js_get_random() - 0.5F) * 2.0F * AUTOMOVE_DIR_VAR_MAX;
-      sphere_vel[0].y =
-          (call_js_get_random() - 0.5F) * 2.0F * AUTOMOVE_DIR_VAR_MAX;
-      sphere_vel[0].z =
-          (call_js_get_random() - 0.5F) * 2.0F * AUTOMOVE_DIR_VAR_MAX;
-
-      sphere_vel[0] = SC_SACD_Vec3_Mult(SC_SACD_Vec3_Normalize(sphere_vel[0]),
-                                        AUTOMOVE_SPEED);
-
-      sphere_vel[1].x =
-          (call_js_get_random() - 0.5F) * 2.0F * AUTOMOVE_DIR_VAR_MAX;
-      sphere_vel[1].y =
-          (call_js_get_random() - 0.5F) * 2.0F * AUTOMOVE_DIR_VAR_MAX;
-      sphere_vel[1].z =
-          (call_js_get_random() - 0.5F) * 2.0F * AUTOMOVE_DIR_VAR_MAX;
-
-      sphere_vel[1] = SC_SACD_Vec3_Mult(SC_SACD_Vec3_Normalize(sphere_vel[1]),
-                                        AUTOMOVE_SPEED);
-
-      sphere_acc[0].y = -SPHERE_DROP_ACC;
-      sphere_acc[1].y = -SPHERE_DROP_ACC;
-      sphere[0].y = 1.0F;
-      sphere[1].y = 1.0F;
+      std::array<float, AUTOMOVE_RANDOM_COUNT> random;
+      rng.fill(random);
+      sim.start_auto_move(random);
     } else {
-      sphere_acc[0].x = 0.0F;
-      sphere_acc[0].y = 0.0F;
-      sphere_acc[0].z = 0.0F;
-      sphere_acc[1].x = 0.0F;
-      sphere_acc[1].y = 0.0F;
-      sphere_acc[1].z = 0.0F;
-
-      sphere_vel[0].x = 0.0F;
-      sphere_vel[0].y = 0.0F;
-      sphere_vel[0].z = 0.0F;
-      sphere_vel[1].x = 0.0F;
-      sphere_vel[1].y = 0.0F;
-      sphere_vel[1].z = 0.0F;
-
-      sphere[0].y = 0.21F;
-      sphere[1].y = 0.21F;
+      sim.stop_auto_move();
     }
   }
 
@@ -281,93 +428,93 @@ bool BattleScreen::update(float dt, bool screen_resized) {
       float z_r_unit_135 = -x_r_unit * SQRT_2D2 + z_r_unit * -SQRT_2D2;
 
       if (IsKeyDown(KEY_D) && IsKeyDown(KEY_S)) {
-        sphere_vel[0].x = MOVEMENT_SPEED * x_r_unit_45;
-        sphere_vel[0].z = MOVEMENT_SPEED * z_r_unit_45;
+        sim.sphere_vel[0].x = MOVEMENT_SPEED * x_r_unit_45;
+        sim.sphere_vel[0].z = MOVEMENT_SPEED * z_r_unit_45;
       } else if (IsKeyDown(KEY_D) && IsKeyDown(KEY_W)) {
-        sphere_vel[0].x = MOVEMENT_SPEED * x_r_unit_135;
-        sphere_vel[0].z = MOVEMENT_SPEED * z_r_unit_135;
+        sim.sphere_vel[0].x = MOVEMENT_SPEED * x_r_unit_135;
+        sim.sphere_vel[0].z = MOVEMENT_SPEED * z_r_unit_135;
       } else if (IsKeyDown(KEY_A) && IsKeyDown(KEY_S)) {
-        sphere_vel[0].x = -MOVEMENT_SPEED * x_r_unit_135;
-        sphere_vel[0].z = -MOVEMENT_SPEED * z_r_unit_135;
+        sim.sphere_vel[0].x = -MOVEMENT_SPEED * x_r_unit_135;
+        sim.sphere_vel[0].z = -MOVEMENT_SPEED * z_r_unit_135;
       } else if (IsKeyDown(KEY_A) && IsKeyDown(KEY_W)) {
-        sphere_vel[0].x = -MOVEMENT_SPEED * x_r_unit_45;
-        sphere_vel[0].z = -MOVEMENT_SPEED * z_r_unit_45;
+        sim.sphere_vel[0].x = -MOVEMENT_SPEED * x_r_unit_45;
+        sim.sphere_vel[0].z = -MOVEMENT_SPEED * z_r_unit_45;
       } else if (IsKeyDown(KEY_D)) {
-        sphere_vel[0].x = -MOVEMENT_SPEED * x_r_unit_90;
-        sphere_vel[0].z = -MOVEMENT_SPEED * z_r_unit_90;
+        sim.sphere_vel[0].x = -MOVEMENT_SPEED * x_r_unit_90;
+        sim.sphere_vel[0].z = -MOVEMENT_SPEED * z_r_unit_90;
       } else if (IsKeyDown(KEY_A)) {
-        sphere_vel[0].x = MOVEMENT_SPEED * x_r_unit_90;
-        sphere_vel[0].z = MOVEMENT_SPEED * z_r_unit_90;
+        sim.sphere_vel[0].x = MOVEMENT_SPEED * x_r_unit_90;
+        sim.sphere_vel[0].z = MOVEMENT_SPEED * z_r_unit_90;
       } else if (IsKeyDown(KEY_S)) {
-        sphere_vel[0].x = MOVEMENT_SPEED * x_r_unit;
-        sphere_vel[0].z = MOVEMENT_SPEED * z_r_unit;
+        sim.sphere_vel[0].x = MOVEMENT_SPEED * x_r_unit;
+        sim.sphere_vel[0].z = MOVEMENT_SPEED * z_r_unit;
       } else if (IsKeyDown(KEY_W)) {
-        sphere_vel[0].x = -MOVEMENT_SPEED * x_r_unit;
-        sphere_vel[0].z = -MOVEMENT_SPEED * z_r_unit;
+        sim.sphere_vel[0].x = -MOVEMENT_SPEED * x_r_unit;
+        sim.sphere_vel[0].z = -MOVEMENT_SPEED * z_r_unit;
       } else {
-        sphere_vel[0].x = 0.0F;
-        sphere_vel[0].z = 0.0F;
+        sim.sphere_vel[0].x = 0.0F;
+        sim.sphere_vel[0].z = 0.0F;
       }
 
       if (IsKeyDown(KEY_RIGHT) && IsKeyDown(KEY_DOWN)) {
-        sphere_vel[1].x = MOVEMENT_SPEED * x_r_unit_45;
-        sphere_vel[1].z = MOVEMENT_SPEED * z_r_unit_45;
+        sim.sphere_vel[1].x = MOVEMENT_SPEED * x_r_unit_45;
+        sim.sphere_vel[1].z = MOVEMENT_SPEED * z_r_unit_45;
       } else if (IsKeyDown(KEY_RIGHT) && IsKeyDown(KEY_UP)) {
-        sphere_vel[1].x = MOVEMENT_SPEED * x_r_unit_135;
-        sphere_vel[1].z = MOVEMENT_SPEED * z_r_unit_135;
+        sim.sphere_vel[1].x = MOVEMENT_SPEED * x_r_unit_135;
+        sim.sphere_vel[1].z = MOVEMENT_SPEED * z_r_unit_135;
       } else if (IsKeyDown(KEY_DOWN) && IsKeyDown(KEY_LEFT)) {
-        sphere_vel[1].x = -MOVEMENT_SPEED * x_r_unit_135;
-        sphere_vel[1].z = -MOVEMENT_SPEED * z_r_unit_135;
+        sim.sphere_vel[1].x = -MOVEMENT_SPEED * x_r_unit_135;
+        sim.sphere_vel[1].z = -MOVEMENT_SPEED * z_r_unit_135;
       } else if (IsKeyDown(KEY_UP) && IsKeyDown(KEY_LEFT)) {
-        sphere_vel[1].x = -MOVEMENT_SPEED * x_r_unit_45;
-        sphere_vel[1].z = -MOVEMENT_SPEED * z_r_unit_45;
+        sim.sphere_vel[1].x = -MOVEMENT_SPEED * x_r_unit_45;
+        sim.sphere_vel[1].z = -MOVEMENT_SPEED * z_r_unit_45;
       } else if (IsKeyDown(KEY_LEFT)) {
-        sphere_vel[1].x = MOVEMENT_SPEED * x_r_unit_90;
-        sphere_vel[1].z = MOVEMENT_SPEED * z_r_unit_90;
+        sim.sphere_vel[1].x = MOVEMENT_SPEED * x_r_unit_90;
+        sim.sphere_vel[1].z = MOVEMENT_SPEED * z_r_unit_90;
       } else if (IsKeyDown(KEY_RIGHT)) {
-        sphere_vel[1].x = -MOVEMENT_SPEED * x_r_unit_90;
-        sphere_vel[1].z = -MOVEMENT_SPEED * z_r_unit_90;
+        sim.sphere_vel[1].x = -MOVEMENT_SPEED * x_r_unit_90;
+        sim.sphere_vel[1].z = -MOVEMENT_SPEED * z_r_unit_90;
       } else if (IsKeyDown(KEY_DOWN)) {
-        sphere_vel[1].x = MOVEMENT_SPEED * x_r_unit;
-        sphere_vel[1].z = MOVEMENT_SPEED * z_r_unit;
+        sim.sphere_vel[1].x = MOVEMENT_SPEED * x_r_unit;
+        sim.sphere_vel[1].z = MOVEMENT_SPEED * z_r_unit;
       } else if (IsKeyDown(KEY_UP)) {
-        sphere_vel[1].x = -MOVEMENT_SPEED * x_r_unit;
-        sphere_vel[1].z = -MOVEMENT_SPEED * z_r_unit;
+        sim.sphere_vel[1].x = -MOVEMENT_SPEED * x_r_unit;
+        sim.sphere_vel[1].z = -MOVEMENT_SPEED * z_r_unit;
       } else {
-        sphere_vel[1].x = 0.0F;
-        sphere_vel[1].z = 0.0F;
+        sim.sphere_vel[1].x = 0.0F;
+        sim.sphere_vel[1].z = 0.0F;
       }
     } else {
       if (IsKeyDown(KEY_D)) {
-        sphere_vel[0].x = MOVEMENT_SPEED;
+        sim.sphere_vel[0].x = MOVEMENT_SPEED;
       } else if (IsKeyDown(KEY_A)) {
-        sphere_vel[0].x = -MOVEMENT_SPEED;
+        sim.sphere_vel[0].x = -MOVEMENT_SPEED;
       } else {
-        sphere_vel[0].x = 0.0F;
+        sim.sphere_vel[0].x = 0.0F;
       }
 
       if (IsKeyDown(KEY_W)) {
-        sphere_vel[0].z = -MOVEMENT_SPEED;
+        sim.sphere_vel[0].z = -MOVEMENT_SPEED;
       } else if (IsKeyDown(KEY_S)) {
-        sphere_vel[0].z = MOVEMENT_SPEED;
+        sim.sphere_vel[0].z = MOVEMENT_SPEED;
       } else {
-        sphere_vel[0].z = 0.0F;
+        sim.sphere_vel[0].z = 0.0F;
       }
 
       if (IsKeyDown(KEY_RIGHT)) {
-        sphere_vel[1].x = MOVEMENT_SPEED;
+        sim.sphere_vel[1].x = MOVEMENT_SPEED;
       } else if (IsKeyDown(KEY_LEFT)) {
-        sphere_vel[1].x = -MOVEMENT_SPEED;
+        sim.sphere_vel[1].x = -MOVEMENT_SPEED;
       } else {
-        sphere_vel[1].x = 0.0F;
+        sim.sphere_vel[1].x = 0.0F;
       }
 
       if (IsKeyDown(KEY_UP)) {
-        sphere_vel[1].z = -MOVEMENT_SPEED;
+        sim.sphere_vel[1].z = -MOVEMENT_SPEED;
       } else if (IsKeyDown(KEY_DOWN)) {
-        sphere_vel[1].z = MOVEMENT_SPEED;
+        sim.sphere_vel[1].z = MOVEMENT_SPEED;
       } else {
-        sphere_vel[1].z = 0.0F;
+        sim.sphere_vel[1].z = 0.0F;
       }
     }
   }
@@ -376,8 +523,6 @@ bool BattleScreen::update(float dt, bool screen_resized) {
   //   camera_orbit_timer -= CAMERA_ORBIT_TIME;
   // }
 
-  floor_timer += dt;
-
   /*  camera.position.z = std::cos(camera_orbit_timer / CAMERA_ORBIT_TIME **/
   /*                               std::numbers::pi_v<float> * 2.0F) **/
   /*                      CAMERA_ORBIT_XZ;*/
@@ -385,105 +530,29 @@ bool BattleScreen::update(float dt, bool screen_resized) {
   /*                               std::numbers::pi_v<float> * 2.0F) **/
   /*                      CAMERA_ORBIT_XZ;*/
 
-  for (unsigned int idx = 0; idx < 2; ++idx) {
-    sphere_vel[idx].x += sphere_acc[idx].x * dt;
-    sphere_vel[idx].y += sphere_acc[idx].y * dt;
-    sphere_vel[idx].z += sphere_acc[idx].z * dt;
-
-    sphere_prev_pos[idx].x = sphere[idx].x;
-    sphere_prev_pos[idx].y = sphere[idx].y;
-    sphere_prev_pos[idx].z = sphere[idx].z;
-
-    sphere[idx].x += sphere_vel[idx].x * dt;
-    sphere[idx].y += sphere_vel[idx].y * dt;
-    sphere[idx].z += sphere_vel[idx].z * dt;
-  }
-
-  if (auto flag_opt = shared_data.get_flag(enable_auto_move_flag);
-      flag_opt.has_value() && flag_opt.value()) {
-    // Check collision with other.
-    bool collided = SC_SACD_Sphere_Collision(sphere[0], sphere[1]) != 0;
-    if (sphere_collided && !collided) {
-      sphere_collided = false;
-    } else if (collided) {
-      SC_SACD_Vec3 normal{sphere[0].x - sphere[1].x, sphere[0].y - sphere[1].y,
-                          sphere[0].z - sphere[1].z};
-
-      // Move spheres to point before collision.
-
-      sphere[0].x = sphere_prev_pos[0].x;
-      sphere[0].y = sphere_prev_pos[0].y;
-      sphere[0].z = sphere_prev_pos[0].z;
-      sphere[1].x = sphere_prev_pos[1].x;
-      sphere[1].y = sphere_prev_pos[1].y;
-      sphere[1].z = sphere_prev_pos[1].z;
-
-      // Get projection onto normal.
-
-      float temp = SC_SACD_Dot_Product(normal, normal);
-
-      float dot_product[2] = {
-          SC_SACD_Dot_Product(normal, sphere_vel[0]) / temp,
-          SC_SACD_Dot_Product(normal, sphere_vel[1]) / temp};
-      SC_SACD_Vec3 proj[2] = {
-          SC_SACD_Vec3{dot_product[0] * normal.x, dot_product[0] * normal.y,
-                       dot_product[0] * normal.z},
-          SC_SACD_Vec3{dot_product[1] * normal.x, dot_product[1] * normal.y,
-                       dot_product[1] * normal.z}};
-
-      // Get reflection over normal, and negate it to get desired result.
-
-      sphere_vel[0].x = -(proj[0].x * 2.0F - sphere_vel[0].x);
-      sphere_vel[0].y = -(proj[0].y * 2.0F - sphere_vel[0].y);
-      sphere_vel[0].z = -(proj[0].z * 2.0F - sphere_vel[0].z);
-      sphere_vel[1].x = -(proj[1].x * 2.0F - sphere_vel[1].x);
-      sphere_vel[1].y = -(proj[1].y * 2.0F - sphere_vel[1].y);
-      sphere_vel[1].z = -(proj[1].z * 2.0F - sphere_vel[1].z);
-
-      sphere_collided = true;
-    }
+  {
+    auto flag_opt = shared_data.get_flag(enable_auto_move_flag);
+    sim.step(dt, flag_opt.has_value() && flag_opt.value());
   }
 
-  // Check collision with wall.
+  // Published for the per-tick script hooks, only allocates the first time.
+  shared_data.combatants.resize(2);
   for (unsigned int idx = 0; idx < 2; ++idx) {
-    if (sphere[idx].x - sphere[idx].radius < -SPACE_WIDTH) {
-      sphere[idx].x = sphere_prev_pos[idx].x;
-      sphere_vel[idx].x = std::abs(sphere_vel[idx].x);
-    } else if (sphere[idx].x + sphere[idx].radius > SPACE_WIDTH) {
-      sphere[idx].x = sphere_prev_pos[idx].x;
-      sphere_vel[idx].x = -std::abs(sphere_vel[idx].x);
-    }
-
-    if (sphere[idx].z - sphere[idx].radius < -SPACE_DEPTH) {
-      sphere[idx].z = sphere_prev_pos[idx].z;
-      sphere_vel[idx].z = std::abs(sphere_vel[idx].z);
-    } else if (sphere[idx].z + sphere[idx].radius > SPACE_DEPTH) {
-      sphere[idx].z = sphere_prev_pos[idx].z;
-      sphere_vel[idx].z = -std::abs(sphere_vel[idx].z);
-    }
-
-    // Check collision with ground.
-    /*    if (sphere[idx].y - sphere[idx].radius < 0.0F) {*/
-    if (SC_SACD_Sphere_AABB_Box_Collision(sphere[idx], floor_box)) {
-      sphere_touch_point[idx].x = sphere[idx].x;
-      sphere_touch_point[idx].y = sphere_prev_pos[idx].y - sphere[idx].radius;
-      sphere_touch_point[idx].z = sphere[idx].z;
-      sphere[idx].y = sphere_prev_pos[idx].y;
-      sphere_vel[idx].y = std::abs(sphere_vel[idx].y);
-      floor_timer = 0.0F;
-    }
+    shared_data.combatants[idx] = {
+        sim.sphere[idx].x,     sim.sphere[idx].y,     sim.sphere[idx].z,
+        sim.sphere_vel[idx].x, sim.sphere_vel[idx].y, sim.sphere_vel[idx].z};
   }
 
-  ground_pos[0] = sphere[0].x;
-  ground_pos[1] = sphere[0].z;
-  ground_pos[2] = sphere[1].x;
-  ground_pos[3] = sphere[1].z;
+  ground_pos[0] = sim.sphere[0].x;
+  ground_pos[1] = sim.sphere[0].z;
+  ground_pos[2] = sim.sphere[1].x;
+  ground_pos[3] = sim.sphere[1].z;
 
   if (combat_camera_enabled) {
-    camera.target.x = sphere[0].x + x_diff;
-    camera.target.z = sphere[0].z + z_diff;
+    camera.target.x = sim.sphere[0].x + x_diff;
+    camera.target.z = sim.sphere[0].z + z_diff;
 
-    float target_y = (sphere[0].y + sphere[1].y) / 2.0F;
+    float target_y = (sim.sphere[0].y + sim.sphere[1].y) / 2.0F;
     camera.target.y += (target_y - camera.target.y) / COMBAT_CAM_Y_FACTOR;
 
     camera.position.x =
@@ -493,10 +562,10 @@ bool BattleScreen::update(float dt, bool screen_resized) {
     camera.position.y = COMBAT_CAMERA_HEIGHT;
   } else {
     // TODO DEBUG
-    camera.target.x = sphere[0].x;
-    camera.position.x = sphere[0].x;
-    camera.target.z = sphere[0].z;
-    camera.position.z = sphere[0].z + CAMERA_ORBIT_XZ;
+    camera.target.x = sim.sphere[0].x;
+    camera.position.x = sim.sphere[0].x;
+    camera.target.z = sim.sphere[0].z;
+    camera.position.z = sim.sphere[0].z + CAMERA_ORBIT_XZ;
 
     camera.position.y = CAMERA_HEIGHT;
   }
@@ -519,6 +588,17 @@ bool BattleScreen::update(float dt, bool screen_resized) {
 
   UpdateMusicStream(battle_music);
 
+  if (auto flag_opt = shared_data.get_flag(cheap_ground_flag);
+      flag_opt.has_value() && prev_cheap_ground_value != flag_opt.value()) {
+    prev_cheap_ground_value = flag_opt.value();
+    ground_model.materials[0].shader =
+        prev_cheap_ground_value ? ground_shader_cheap : ground_shader;
+#ifndef NDEBUG
+    TraceLog(LOG_INFO, "Using %s ground shader.",
+             prev_cheap_ground_value ? "cheap" : "full");
+#endif
+  }
+
   return false;
 }
 
@@ -528,29 +608,29 @@ bool BattleScreen::draw(RenderTexture *render_texture) {
   BeginMode3D(camera);
 
   DrawGrid(20, 0.2F);
-  DrawSphere(Vector3{sphere[0].x, sphere[0].y, sphere[0].z}, sphere[0].radius,
-             GREEN);
-  DrawSphere(Vector3{sphere[1].x, sphere[1].y, sphere[1].z}, sphere[1].radius,
-             RED);
+  DrawSphere(Vector3{sim.sphere[0].x, sim.sphere[0].y, sim.sphere[0].z},
+             sim.sphere[0].radius, GREEN);
+  DrawSphere(Vector3{sim.sphere[1].x, sim.sphere[1].y, sim.sphere[1].z},
+             sim.sphere[1].radius, RED);
   for (unsigned int idx = 0; idx < 2; ++idx) {
-    DrawSphere(Vector3{sphere_touch_point[idx].x, sphere_touch_point[idx].y,
-                       sphere_touch_point[idx].z},
-               0.02F, RED);
+    DrawSphere(
+        Vector3{sim.sphere_touch_point[idx].x, sim.sphere_touch_point[idx].y,
+                sim.sphere_touch_point[idx].z},
+        0.02F, RED);
   }
 
-  SetShaderValue(ground_shader, ground_shader_pos_idx, ground_pos,
-                 SHADER_UNIFORM_VEC2);
-  SetShaderValue(ground_shader, ground_shader_other_pos_idx, ground_pos + 2,
-                 SHADER_UNIFORM_VEC2);
-  DrawModel(ground_model, Vector3{sphere[0].x, -0.011F, sphere[0].z}, 1.0F,
-            Color{0, 128, 0, 255});
-
-  SetShaderValue(ground_shader, ground_shader_pos_idx, ground_pos + 2,
-                 SHADER_UNIFORM_VEC2);
-  SetShaderValue(ground_shader, ground_shader_other_pos_idx, ground_pos,
-                 SHADER_UNIFORM_VEC2);
-  DrawModel(ground_model, Vector3{sphere[1].x, -0.01F, sphere[1].z}, 1.0F,
-            Color{0, 128, 0, 255});
+  // All ground circles are drawn in one instanced pass, each instance reading
+  // every circle's position from the "positions" uniform array.
+  for (unsigned int idx = 0; idx < GROUND_CIRCLES; ++idx) {
+    ground_transforms[idx] = MatrixTranslate(
+        sim.sphere[idx].x, -0.011F + 0.001F * (float)idx, sim.sphere[idx].z);
+  }
+  SetShaderValueV(ground_model.materials[0].shader,
+                  prev_cheap_ground_value ? ground_shader_cheap_positions_idx
+                                          : ground_shader_positions_idx,
+                  ground_pos, SHADER_UNIFORM_VEC2, GROUND_CIRCLES);
+  DrawMeshInstanced(ground_model.meshes[0], ground_model.materials[0],
+                    ground_transforms, GROUND_CIRCLES);
 
   EndMode3D();
   EndTextureMode();
@@ -558,5 +638,36 @@ bool BattleScreen::draw(RenderTexture *render_texture) {
 }
 
 std::list<std::string> BattleScreen::get_known_flags() const {
-  return {enable_auto_move_flag, enable_music_flag, combat_camera_flag};
+  return {enable_auto_move_flag, enable_music_flag, combat_camera_flag,
+          cheap_ground_flag};
+}
+
+void BattleScreen::set_canned_state(float t) {
+  // Two spheres orbiting at different rates, so their ground circles
+  // periodically overlap, bouncing off the floor.
+  sim.sphere[0].x = std::cos(t) * 1.5F;
+  sim.sphere[0].z = std::sin(t) * 1.5F;
+  sim.sphere[0].y = 0.21F + std::abs(std::sin(t * 3.0F)) * 0.5F;
+  sim.sphere[1].x = std::cos(t * -0.7F) * 1.0F;
+  sim.sphere[1].z = std::sin(t * -0.7F) * 1.0F;
+  sim.sphere[1].y = 0.21F + std::abs(std::cos(t * 2.0F)) * 0.5F;
+
+  for (unsigned int idx = 0; idx < 2; ++idx) {
+    sim.sphere_touch_point[idx].x = sim.sphere[idx].x;
+    sim.sphere_touch_point[idx].y = 0.0F;
+    sim.sphere_touch_point[idx].z = sim.sphere[idx].z;
+  }
+
+  ground_pos[0] = sim.sphere[0].x;
+  ground_pos[1] = sim.sphere[0].z;
+  ground_pos[2] = sim.sphere[1].x;
+  ground_pos[3] = sim.sphere[1].z;
+
+  float orbit = t / CAMERA_ORBIT_TIME * std::numbers::pi_v<float> * 2.0F;
+  camera.target.x = 0.0F;
+  camera.target.y = 0.0F;
+  camera.target.z = 0.0F;
+  camera.position.x = std::sin(orbit) * CAMERA_ORBIT_XZ;
+  camera.position.y = CAMERA_HEIGHT;
+  camera.position.z = std::cos(orbit) * CAMERA_ORBIT_XZ;
 }
@@ -1,11 +1,13 @@
 #ifndef SEODISPARATE_COM_GANDER_BATTLE_SCREEN_BATTLE_H_
 #define SEODISPARATE_COM_GANDER_BATTLE_SCREEN_BATTLE_H_
 
+#include "battle_sim.h"
+#include "resource_handler.h"
+#include "rng.h"
 #include "screen.h"
 
 // Third party includes.
 #include <raylib.h>
-#include <sc_sacd.h>
 
 // Constants.
 constexpr float CAMERA_ORBIT_TIME = 20.0F;
@@ -15,20 +17,18 @@ constexpr float COMBAT_CAMERA_DIST = 3.0F;
 constexpr float COMBAT_CAM_Y_FACTOR = 200.0F;
 constexpr float CAMERA_ORBIT_XZ = 5.0F;
 
-constexpr float SPHERE_DROP_ACC = 9.8F;
-
-constexpr float SPACE_WIDTH = 2.5F;
-constexpr float SPACE_DEPTH = 2.5F;
-
-constexpr float FLOOR_TIME_MAX = 1.0F;
-
 constexpr float SHADER_GROUND_SCALE = 0.1F;
 constexpr int GROUND_PLANE_SIZE = 5;
 constexpr float GROUND_PLANE_SIZE_F = (float)GROUND_PLANE_SIZE;
+/// Number of ground circles drawn (one per sphere).
+constexpr int GROUND_CIRCLES = 2;
+/// Size of the ground shader's "positions" uniform array.
+constexpr int GROUND_CIRCLES_MAX = 8;
+static_assert(GROUND_CIRCLES <= GROUND_CIRCLES_MAX);
+/// Width and height of the cheap ground shader's falloff mask.
+constexpr int GROUND_FALLOFF_SIZE = 128;
 
 constexpr float MOVEMENT_SPEED = 1.0F;
-constexpr float AUTOMOVE_DIR_VAR_MAX = 2.0F;
-constexpr float AUTOMOVE_SPEED = 3.0F;
 
 class BattleScreen : public Screen {
  public:
@@ -41,30 +41,34 @@ class BattleScreen : public Screen {
 
   virtual std::list<std::string> get_known_flags() const override;
 
+  /// Starts loading BattleScreen's assets, so constructing it doesn't wait on
+  /// disk.
+  static void prefetch(ResourceLoader &loader);
+
+  /// Places the spheres and camera "t" seconds along a fixed, deterministic
+  /// path. Used by the benchmark to replay the same frames every run.
+  void set_canned_state(float t);
+
  private:
   Camera3D camera;
   float camera_orbit_timer;
-  float floor_timer;
-  SC_SACD_Sphere sphere[2];
-  SC_SACD_Vec3 sphere_vel[2];
-  SC_SACD_Vec3 sphere_acc[2];
-  SC_SACD_Vec3 sphere_touch_point[2];
-  SC_SACD_Vec3 sphere_prev_pos[2];
-  SC_SACD_AABB_Box floor_box;
+  BattleSim sim;
+  /// Split off of SharedData's, picks the auto movement directions.
+  Rng rng;
   Model ground_model;
   Shader ground_shader;
+  Shader ground_shader_cheap;
   Music battle_music;
-  std::vector<char> music_data;
-  int ground_shader_scale_idx;
-  int ground_shader_pos_idx;
-  int ground_shader_other_pos_idx;
-  int ground_shader_radius_idx;
-  int ground_shader_ground_size_idx;
+  /// Streamed from by battle_music, so must outlive it.
+  ResourceHandler::View music_data;
+  int ground_shader_positions_idx;
+  int ground_shader_cheap_positions_idx;
   float ground_scale;
-  float ground_pos[4];
-  bool sphere_collided;
+  float ground_pos[GROUND_CIRCLES * 2];
+  Matrix ground_transforms[GROUND_CIRCLES];
   bool prev_auto_move_flag_value;
   bool prev_music_play_value;
+  bool prev_cheap_ground_value;
 };
 
 #endif
@@ -5,6 +5,7 @@
 #include <cstring>
 #include <format>
 #include <iostream>
+#include <utility>
 
 // Third party includes.
 #include <raylib.h>
@@ -18,13 +19,224 @@ extern "C" {
 #include "constants.h"
 #include "screen.h"
 #include "screen_battle.h"
+#include "startup_trace.h"
 
 using namespace std::string_literals;
 
+constexpr std::size_t CONSOLE_SCROLLBACK_MAX = 1000;
+constexpr unsigned int CONSOLE_VISIBLE_LINES = SCREEN_HEIGHT / 24 - 1;
+constexpr float CONSOLE_FONT_SIZE = 20.0F;
+// Matches DrawText()'s spacing for the default font.
+constexpr float CONSOLE_FONT_SPACING = CONSOLE_FONT_SIZE / 10.0F;
+
+constexpr int FRAME_GRAPH_X = 10;
+constexpr int FRAME_GRAPH_Y = 45;
+constexpr int FRAME_GRAPH_HEIGHT = 60;
+/// Graph height covers two 60 fps frames.
+constexpr float FRAME_GRAPH_PX_PER_MS = (float)FRAME_GRAPH_HEIGHT / 33.3F;
+
+/// Default ceiling of the Duktape heap, change it with set_memory_limit().
+constexpr std::size_t JS_HEAP_LIMIT = 64 * 1024 * 1024;
+
+/// Frames shorter than this count as idle, for prewarming the scripting state.
+constexpr float SCRIPT_PREWARM_IDLE_DT = 1.0F / 90.0F;
+
+/// Run once when their state is created, if present.
+constexpr const char *const LUA_BOOT_SCRIPT = "res/scripts/boot.lua";
+constexpr const char *const JS_BOOT_SCRIPT = "res/scripts/boot.js";
+
+/// Seconds per frame shared by all on_tick() hooks, hooks that don't fit are
+/// deferred to the next frame. A JS hook that runs past it is removed, as it
+/// can't be suspended.
+constexpr double SCRIPT_TICK_BUDGET = 0.002;
+/// Lua instructions between checks of the script deadline, and between
+/// profiler samples.
+constexpr int SCRIPT_HOOK_COUNT = 1000;
+/// A Lua hook still unfinished after this many frames in a row is removed.
+constexpr unsigned int SCRIPT_TICK_MAX_DEFERS = 60;
+
+/// Seconds a console line may run on the script thread before it is aborted.
+constexpr double SCRIPT_CONSOLE_TIMEOUT = 5.0;
+/// Seconds per frame the render thread may spend on calls from a running
+/// console line, see ScriptThread::service().
+constexpr double SCRIPT_THREAD_SERVICE_BUDGET = 0.002;
+
+/// Set while the on_tick() hooks run on the render thread, or while a console
+/// line runs on the script thread, 0.0 otherwise.
+static thread_local double script_deadline = 0.0;
+
+/// Lines printed by profile_report() without an argument.
+constexpr std::size_t SCRIPT_PROFILE_REPORT_LINES = 10;
+
+/// Set between profile_start() and profile_stop(), for the hooks sampling the
+/// scripts.
+static ScriptProfiler *lua_active_profiler = nullptr;
+static ScriptProfiler *js_active_profiler = nullptr;
+
+bool script_expired() {
+  if (ScriptThread *thread = ScriptThread::current();
+      thread && thread->is_finishing()) {
+    return true;
+  }
+  return script_deadline > 0.0 && GetTime() > script_deadline;
+}
+
+// Shared by the Lua and JS "print_frame_stats()".
+void print_frame_stats(SharedData &shared) {
+  const std::pair<const char *, FrameTimes::Part> parts[] = {
+      {"update", FrameTimes::Part::UPDATE},
+      {"draw", FrameTimes::Part::DRAW},
+      {"present", FrameTimes::Part::PRESENT},
+      {"total", FrameTimes::Part::TOTAL}};
+  shared.outputs.push_back("  Frame times (ms):");
+  for (const auto &[name, part] : parts) {
+    auto stats = shared.frame_times.get_stats(part);
+    shared.outputs.push_back(
+        std::format("{}: p50 {:.2f} p95 {:.2f} p99 {:.2f} max {:.2f}", name,
+                    stats.p50, stats.p95, stats.p99, stats.max));
+  }
+}
+
+// Shared by the Lua and JS "print_vm_memory()".
+void print_vm_memory(SharedData &shared, const PoolAllocator &lua_allocator,
+                     const PoolAllocator &js_allocator) {
+  const std::pair<const char *, const PoolAllocator *> vms[] = {
+      {"Lua", &lua_allocator}, {"Duktape", &js_allocator}};
+  shared.outputs.push_back("  Scripting memory (KiB):");
+  for (const auto &[name, allocator] : vms) {
+    auto stats = allocator->get_stats();
+    shared.outputs.push_back(
+        std::format("{}: in use {:.1f} peak {:.1f} reserved {:.1f}", name,
+                    (double)stats.in_use / 1024.0, (double)stats.peak / 1024.0,
+                    (double)stats.reserved / 1024.0));
+  }
+}
+
+// #############################################################################
+//  BEGIN bindings of both engines
+// #############################################################################
+// Typed bindings, see script_binding.h. Each is registered in both engines
+// from "script_bindings" below.
+
+ScriptProfiler *&active_profiler(const ScriptEnv &env) {
+  return env.engine == ScriptEngine::LUA ? lua_active_profiler
+                                         : js_active_profiler;
+}
+
+void script_reset_stack(ScriptEnv &env) {
+  env.ss->clear_screens();
+  env.ss->push_constructing_screen<BattleScreen>();
+  if (!env.ss->is_overlay_screen_set()) {
+    env.ss->set_overlay_screen<DebugScreen>();
+  }
+  env.ss->get_shared_data().outputs.push_back("Reset Stack.");
+}
+
+void script_clear_stack(ScriptEnv &env) {
+  env.ss->clear_screens();
+  env.ss->get_shared_data().outputs.push_back("Cleared Stack.");
+}
+
+bool script_get_flag(ScriptEnv &env, std::string_view name) {
+  return env.ss->get_shared_data().get_flag(name).value_or(false);
+}
+
+// Returns the previous value.
+std::optional<bool> script_set_flag(ScriptEnv &env, std::string_view name,
+                                    bool value) {
+  auto &shared = env.ss->get_shared_data();
+  auto result = shared.set_flag_lua(name, value);
+  if (!result.has_value()) {
+    shared.outputs.push_back("set_flag(...) invalid name!");
+  }
+  return result;
+}
+
+std::optional<bool> script_toggle_flag(ScriptEnv &env, std::string_view name) {
+  auto &shared = env.ss->get_shared_data();
+  auto result = shared.toggle_flag_lua(name);
+  if (!result.has_value()) {
+    shared.outputs.push_back("toggle_flag(...) invalid name!");
+  }
+  return result;
+}
+
+void script_print_known_flags(ScriptEnv &env) {
+  auto &outputs = env.ss->get_shared_data().outputs;
+  outputs.push_back("  Known flags:");
+  for (auto &flag : env.ss->get_known_flags()) {
+    outputs.push_back(std::move(flag));
+  }
+}
+
+void script_print_frame_stats(ScriptEnv &env) {
+  print_frame_stats(env.ss->get_shared_data());
+}
+
+// 0 for unlimited.
+void script_set_memory_limit(ScriptEnv &env, std::size_t bytes) {
+  env.allocator->set_limit(bytes);
+}
+
+void script_print_vm_memory(ScriptEnv &env) {
+  if (env.engine == ScriptEngine::LUA) {
+    print_vm_memory(env.ss->get_shared_data(), *env.allocator,
+                    *env.other_allocator);
+  } else {
+    print_vm_memory(env.ss->get_shared_data(), *env.other_allocator,
+                    *env.allocator);
+  }
+}
+
+// Duktape can't walk its call stack from the executor's interrupt (see
+// gander_duk_exec_timeout()), so JS samples are by entry point: a console
+// line or an on_tick() hook.
+void script_profile_start(ScriptEnv &env) {
+  active_profiler(env) = env.profiler;
+  env.profiler->start();
+  if (env.engine == ScriptEngine::LUA) {
+    env.ss->get_shared_data().outputs.push_back(
+        "Profiling Lua, see profile_report()");
+  } else {
+    env.profiler->set_entry("console");
+    env.ss->get_shared_data().outputs.push_back(
+        "Profiling JS by entry point, see profile_report()");
+  }
+}
+
+void script_profile_stop(ScriptEnv &env) {
+  env.profiler->stop();
+  active_profiler(env) = nullptr;
+}
+
+void script_profile_report(ScriptEnv &env, std::optional<std::size_t> count) {
+  auto &outputs = env.ss->get_shared_data().outputs;
+  for (auto &line :
+       env.profiler->report(count.value_or(SCRIPT_PROFILE_REPORT_LINES))) {
+    outputs.push_back(std::move(line));
+  }
+}
+
+std::size_t script_get_sphere_count(ScriptEnv &env) {
+  return env.ss->get_shared_data().combatants.size();
+}
+
+// Lists "script_bindings", defined once the engine specific ones are.
+void script_get_help(ScriptEnv &env);
+
+// #############################################################################
+//  END bindings of both engines
+// #############################################################################
+
 // #############################################################################
 //  BEGIN Lua stuff
 // #############################################################################
 ScreenStack *get_lua_screen_stack(lua_State *l) {
+  return lua_script_env(l).ss;
+}
+
+// For code not called from Lua, like lua_run_tick_hooks().
+ScreenStack *get_lua_registry_screen_stack(lua_State *l) {
   // +1
   lua_pushstring(l, "user_stack_ptr");
   // +1, -1
@@ -37,33 +249,10 @@ ScreenStack *get_lua_screen_stack(lua_State *l) {
   return reinterpret_cast<ScreenStack *>(ptr);
 }
 
-void *alloc_for_lua(void *ud, void *ptr, std::size_t osize, std::size_t nsize) {
-  if (nsize == 0) {
-    if (ptr) {
-      std::free(ptr);
-    }
-    return nullptr;
-  }
-
-  return std::realloc(ptr, nsize);
-}
-
-int lua_reset_stack(lua_State *l) {
-  ScreenStack *ss = get_lua_screen_stack(l);
-  ss->clear_screens();
-  ss->push_constructing_screen<BattleScreen>();
-  if (!ss->is_overlay_screen_set()) {
-    ss->set_overlay_screen<DebugScreen>();
-  }
-  ss->get_shared_data().outputs.push_back("Reset Stack.");
-  return 0;
-}
-
-int lua_clear_stack(lua_State *l) {
-  ScreenStack *ss = get_lua_screen_stack(l);
-  ss->clear_screens();
-  ss->get_shared_data().outputs.push_back("Cleared Stack.");
-  return 0;
+PoolAllocator *get_lua_allocator(lua_State *l) {
+  void *ud;
+  lua_getallocf(l, &ud);
+  return static_cast<PoolAllocator *>(ud);
 }
 
 int lua_generic_print(lua_State *l) {
@@ -112,30 +301,6 @@ int lua_generic_print(lua_State *l) {
   return 0;
 }
 
-int lua_get_flag(lua_State *l) {
-  ScreenStack *ss = get_lua_screen_stack(l);
-
-  int top = lua_gettop(l);
-  if (top != 1) {
-    ss->get_shared_data().outputs.push_back(
-        "Not 1 arg! usage: get_flag(\"name\") returns boolean");
-    return 0;
-  } else if (!lua_isstring(l, 1)) {
-    ss->get_shared_data().outputs.push_back(
-        "1st arg not string! usage: get_flag(\"name\") returns boolean");
-    return 0;
-  }
-  const char *name = lua_tostring(l, 1);
-  auto result = ss->get_shared_data().get_flag(name);
-
-  if (result.has_value() && result.value()) {
-    lua_pushboolean(l, 1);
-  } else {
-    lua_pushboolean(l, 0);
-  }
-  return 1;
-}
-
 int lua_print_flags(lua_State *l) {
   ScreenStack *ss = get_lua_screen_stack(l);
 
@@ -157,93 +322,323 @@ int lua_print_flags(lua_State *l) {
   return 0;
 }
 
-int lua_set_flag(lua_State *l) {
+int lua_get_frame_stats(lua_State *l) {
   ScreenStack *ss = get_lua_screen_stack(l);
 
   int top = lua_gettop(l);
-  if (top != 2) {
-    ss->get_shared_data().outputs.push_back(
-        "Not 2 args! usage: set_flag(\"name\", boolean) returns prev boolean");
-    return 0;
-  } else if (!lua_isstring(l, 1)) {
+  std::optional<FrameTimes::Part> part = FrameTimes::Part::TOTAL;
+  if (top > 1) {
     ss->get_shared_data().outputs.push_back(
-        "1st arg not string! usage: set_flag(\"name\", boolean) returns prev "
-        "boolean");
-    return 0;
-  } else if (!lua_isboolean(l, 2)) {
-    ss->get_shared_data().outputs.push_back(
-        "2nd arg not boolean! usage: set_flag(\"name\", boolean) returns prev "
-        "boolean");
+        "Not 0 or 1 args! usage: get_frame_stats([\"part\"]) returns table");
     return 0;
+  } else if (top == 1) {
+    if (!lua_isstring(l, 1)) {
+      ss->get_shared_data().outputs.push_back(
+          "1st arg not string! usage: get_frame_stats([\"part\"]) returns "
+          "table");
+      return 0;
+    }
+    part = FrameTimes::part_from_name(lua_tostring(l, 1));
+    if (!part.has_value()) {
+      ss->get_shared_data().outputs.push_back(
+          "get_frame_stats(...) part must be \"update\", \"draw\", "
+          "\"present\", or \"total\"!");
+      return 0;
+    }
   }
 
-  const char *name = lua_tostring(l, 1);
-  auto b = lua_toboolean(l, 2);
-  auto result = ss->get_shared_data().set_flag_lua(name, b != 0);
+  auto stats = ss->get_shared_data().frame_times.get_stats(part.value());
+  // +1
+  lua_createtable(l, 0, 4);
+  // +1
+  lua_pushnumber(l, stats.p50);
+  // -1
+  lua_setfield(l, -2, "p50");
+  // +1
+  lua_pushnumber(l, stats.p95);
+  // -1
+  lua_setfield(l, -2, "p95");
+  // +1
+  lua_pushnumber(l, stats.p99);
+  // -1
+  lua_setfield(l, -2, "p99");
+  // +1
+  lua_pushnumber(l, stats.max);
+  // -1
+  lua_setfield(l, -2, "max");
+  return 1;
+}
 
-  if (!result.has_value()) {
-    ss->get_shared_data().outputs.push_back("set_flag(...) invalid name!");
+int lua_get_memory_stats(lua_State *l) {
+  auto stats = get_lua_allocator(l)->get_stats();
+  // +1
+  lua_createtable(l, 0, 6);
+  const std::pair<const char *, std::size_t> fields[] = {
+      {"in_use", stats.in_use},
+      {"peak", stats.peak},
+      {"reserved", stats.reserved},
+      {"allocs_last_frame", stats.allocs_last_frame},
+      {"allocs_total", stats.allocs_total},
+      {"limit", stats.limit}};
+  for (const auto &[name, value] : fields) {
+    // +1
+    lua_pushinteger(l, (lua_Integer)value);
+    // -1
+    lua_setfield(l, -2, name);
+  }
+  return 1;
+}
+
+constexpr const char *const lua_tick_hooks_key = "tick_hooks";
+
+/// Frames in a row the on_tick() coroutine "co" was deferred. Kept in the
+/// thread's extra space so deferring doesn't allocate.
+unsigned int &lua_tick_defers(lua_State *co) {
+  return *static_cast<unsigned int *>(lua_getextraspace(co));
+}
+
+void lua_profile_sample(lua_State *l, lua_Debug *ar) {
+  if (lua_getinfo(l, "Sln", ar) != 0) {
+    lua_active_profiler->add_sample(ar->short_src, ar->currentline,
+                                    ar->name ? ar->name : "?");
+  }
+}
+
+// Count hook of the main thread. Samples for the profiler, and stops console
+// lines that ran past their deadline.
+void lua_main_hook(lua_State *l, lua_Debug *ar) {
+  if (lua_active_profiler) {
+    lua_profile_sample(l, ar);
+  }
+  if (script_expired()) {
+    luaL_error(l, "script timed out");
+  }
+}
+
+// Count hook of the on_tick() coroutines, yields them once over budget. Also
+// samples for the profiler, as a thread only has one hook.
+void lua_tick_count_hook(lua_State *l, lua_Debug *ar) {
+  if (lua_active_profiler) {
+    lua_profile_sample(l, ar);
+  }
+  if (script_expired() && lua_isyieldable(l)) {
+    lua_yield(l, 0);
+  }
+}
+
+int lua_on_tick(lua_State *l) {
+  if (lua_gettop(l) != 1 || !lua_isfunction(l, 1)) {
+    get_lua_screen_stack(l)->get_shared_data().outputs.push_back(
+        "usage: on_tick(function(dt) ... end)");
     return 0;
-  } else {
-    lua_pushboolean(l, result.value() ? 1 : 0);
-    return 1;
   }
+
+  // +1
+  lua_getfield(l, LUA_REGISTRYINDEX, lua_tick_hooks_key);
+  // +1
+  lua_State *co = lua_newthread(l);
+  lua_sethook(co, lua_tick_count_hook, LUA_MASKCOUNT, SCRIPT_HOOK_COUNT);
+  lua_tick_defers(co) = 0;
+  // The hook's function stays at the bottom of the coroutine's stack.
+  // +1
+  lua_pushvalue(l, 1);
+  // -1
+  lua_xmove(l, co, 1);
+  // -1
+  lua_rawseti(l, -2, (lua_Integer)lua_rawlen(l, -2) + 1);
+  // -1
+  lua_pop(l, 1);
+  return 0;
 }
 
-int lua_toggle_flag(lua_State *l) {
-  ScreenStack *ss = get_lua_screen_stack(l);
+int lua_clear_ticks(lua_State *l) {
+  // +1
+  lua_createtable(l, 0, 1);
+  // -1
+  lua_setfield(l, LUA_REGISTRYINDEX, lua_tick_hooks_key);
+  return 0;
+}
 
-  int top = lua_gettop(l);
-  if (top != 1) {
-    ss->get_shared_data().outputs.push_back(
-        "Not 1 arg! usage: toggle_flag(\"name\") returns boolean");
+// Returns x, y, z, vx, vy, vz as separate values, so nothing is allocated.
+int lua_get_sphere(lua_State *l) {
+  auto &shared = get_lua_screen_stack(l)->get_shared_data();
+
+  if (lua_gettop(l) != 1 || !lua_isinteger(l, 1)) {
+    shared.outputs.push_back("usage: get_sphere(idx)");
     return 0;
-  } else if (!lua_isstring(l, 1)) {
-    ss->get_shared_data().outputs.push_back(
-        "1st arg not string! usage: toggle_flag(\"name\") returns boolean");
+  }
+  lua_Integer idx = lua_tointeger(l, 1);
+  if (idx < 0 || idx >= (lua_Integer)shared.combatants.size()) {
     return 0;
   }
 
-  const char *name = lua_tostring(l, 1);
-  auto result = ss->get_shared_data().toggle_flag_lua(name);
+  const auto &c = shared.combatants[(std::size_t)idx];
+  for (float value : {c.x, c.y, c.z, c.vx, c.vy, c.vz}) {
+    // +1
+    lua_pushnumber(l, value);
+  }
+  return 6;
+}
 
-  if (!result.has_value()) {
-    ss->get_shared_data().outputs.push_back("toggle_flag(...) invalid name!");
-    return 0;
-  } else {
-    lua_pushboolean(l, result.value() ? 1 : 0);
-    return 1;
+// Resumes the on_tick() hooks round-robin until script_deadline. Hooks
+// not reached, or yielded by lua_tick_count_hook(), continue next frame.
+void lua_run_tick_hooks(lua_State *l, float dt) {
+  auto &shared = get_lua_registry_screen_stack(l)->get_shared_data();
+
+  // +1
+  lua_getfield(l, LUA_REGISTRYINDEX, lua_tick_hooks_key);
+  lua_Integer count = (lua_Integer)lua_rawlen(l, -1);
+  // +1
+  lua_getfield(l, -1, "next");
+  lua_Integer next = lua_tointeger(l, -1);
+  // -1
+  lua_pop(l, 1);
+
+  lua_Integer ran = 0;
+  for (; ran < count && !script_expired(); ++ran) {
+    lua_Integer idx = (next + ran) % count + 1;
+    // +1
+    lua_rawgeti(l, -1, idx);
+    // Still referenced by the hooks table.
+    lua_State *co = lua_tothread(l, -1);
+    // -1
+    lua_pop(l, 1);
+
+    int nres = 0;
+    int result;
+    if (lua_status(co) == LUA_YIELD) {
+      result = lua_resume(co, l, 0, &nres);
+    } else {
+      lua_pushvalue(co, 1);
+      lua_pushnumber(co, dt);
+      result = lua_resume(co, l, 1, &nres);
+    }
+
+    if (result == LUA_OK || result == LUA_YIELD) {
+      lua_pop(co, nres);
+      if (result == LUA_OK) {
+        lua_tick_defers(co) = 0;
+        continue;
+      } else if (++lua_tick_defers(co) < SCRIPT_TICK_MAX_DEFERS) {
+        continue;
+      }
+      shared.outputs.push_back(
+          std::format("Removed tick hook {}, over budget for {} frames", idx,
+                      SCRIPT_TICK_MAX_DEFERS));
+    } else {
+      const char *error = lua_tostring(co, -1);
+      shared.outputs.push_back(std::format("Removed tick hook {}: {}", idx,
+                                           error ? error : "(no message)"));
+    }
+
+    // Remove the failed hook, the ones after it shift down.
+    lua_closethread(co, l);
+    for (lua_Integer i = idx; i < count; ++i) {
+      // +1
+      lua_rawgeti(l, -1, i + 1);
+      // -1
+      lua_rawseti(l, -2, i);
+    }
+    // +1
+    lua_pushnil(l);
+    // -1
+    lua_rawseti(l, -2, count);
+    --count;
+    next = idx - 1;
+    ran = 0;
+    break;
   }
+
+  // +1
+  lua_pushinteger(l, count > 0 ? (next + ran) % count : 0);
+  // -1
+  lua_setfield(l, -2, "next");
+  // -1
+  lua_pop(l, 1);
 }
 
-int lua_print_known_flags(lua_State *l) {
-  ScreenStack *ss = get_lua_screen_stack(l);
+// With a table, sets each of its string keys to that flag's value (false if
+// unknown) and returns it, so one table can be reused. Without, returns a
+// new table of every flag.
+int lua_get_flags(lua_State *l) {
+  auto &shared = get_lua_screen_stack(l)->get_shared_data();
 
-  auto flags = ss->get_known_flags();
-  ss->get_shared_data().outputs.push_back("  Known flags:");
-  for (const auto &flag : flags) {
-    ss->get_shared_data().outputs.push_back(flag);
+  int top = lua_gettop(l);
+  if (top == 0) {
+    // +1
+    lua_createtable(l, 0, (int)shared.flags.size());
+    for (const auto &[name, value] : shared.flags) {
+      // +1
+      lua_pushboolean(l, value ? 1 : 0);
+      // -1
+      lua_setfield(l, -2, name.c_str());
+    }
+    return 1;
+  } else if (top != 1 || !lua_istable(l, 1)) {
+    shared.outputs.push_back("usage: get_flags([table]) returns table");
+    return 0;
   }
 
-  return 0;
+  // +1
+  lua_pushnil(l);
+  // -1, +2
+  while (lua_next(l, 1) != 0) {
+    // -1
+    lua_pop(l, 1);
+    if (lua_type(l, -1) == LUA_TSTRING) {
+      std::size_t size = 0;
+      const char *name = lua_tolstring(l, -1, &size);
+      auto iter = shared.flags.find(std::string_view(name, size));
+      // +1
+      lua_pushvalue(l, -1);
+      // +1
+      lua_pushboolean(l, iter != shared.flags.end() && iter->second ? 1 : 0);
+      // -2
+      lua_rawset(l, 1);
+    }
+  }
+  // +1
+  lua_pushvalue(l, 1);
+  return 1;
 }
 
-int lua_get_help(lua_State *l) {
-  ScreenStack *ss = get_lua_screen_stack(l);
+// Sets every existing flag named in the table, like set_flag().
+int lua_set_flags(lua_State *l) {
+  auto &shared = get_lua_screen_stack(l)->get_shared_data();
 
-  ss->get_shared_data().outputs.push_back("  Functions:");
-  ss->get_shared_data().outputs.push_back("help()");
-  ss->get_shared_data().outputs.push_back("print_known_flags()");
-  ss->get_shared_data().outputs.push_back("toggle_flag(\"name\")");
-  ss->get_shared_data().outputs.push_back("get_flag(\"name\")");
-  ss->get_shared_data().outputs.push_back("print_flags(\"name\", ...)");
-  ss->get_shared_data().outputs.push_back("set_flag(\"name\", boolean)");
-  ss->get_shared_data().outputs.push_back("gen_print(...)");
-  ss->get_shared_data().outputs.push_back("reset_stack()");
-  ss->get_shared_data().outputs.push_back("clear_stack()");
+  if (lua_gettop(l) != 1 || !lua_istable(l, 1)) {
+    shared.outputs.push_back("usage: set_flags({name = boolean, ...})");
+    return 0;
+  }
 
+  unsigned int invalid = 0;
+  // +1
+  lua_pushnil(l);
+  // -1, +2
+  while (lua_next(l, 1) != 0) {
+    if (lua_type(l, -2) == LUA_TSTRING && lua_isboolean(l, -1)) {
+      std::size_t size = 0;
+      const char *name = lua_tolstring(l, -2, &size);
+      if (auto iter = shared.flags.find(std::string_view(name, size));
+          iter != shared.flags.end()) {
+        iter->second = lua_toboolean(l, -1) != 0;
+      } else {
+        ++invalid;
+      }
+    } else {
+      ++invalid;
+    }
+    // -1
+    lua_pop(l, 1);
+  }
+
+  if (invalid != 0) {
+    shared.outputs.push_back(
+        std::format("set_flags(...) skipped {} invalid entries", invalid));
+  }
   return 0;
 }
+
 // #############################################################################
 //  END Lua stuff
 // #############################################################################
@@ -258,6 +653,11 @@ constexpr const char *const duktape_hidden_symbol_ss_object =
     "gander_screen_stack_object_d208f8c29833afefe848b0d3e6c40418c5bec16f";
 
 ScreenStack *get_js_screen_stack(duk_context *ctx) {
+  return js_script_env(ctx).ss;
+}
+
+// For code not called from JS, like js_run_tick_hooks().
+ScreenStack *get_js_global_screen_stack(duk_context *ctx) {
   // +1
   duk_get_global_string(ctx, duktape_hidden_symbol_ss_object);
   // +1
@@ -270,26 +670,6 @@ ScreenStack *get_js_screen_stack(duk_context *ctx) {
   return ss_ptr;
 }
 
-// No args.
-duk_ret_t js_reset_stack(duk_context *ctx) {
-  ScreenStack *ss = get_js_screen_stack(ctx);
-  ss->clear_screens();
-  ss->push_constructing_screen<BattleScreen>();
-  if (!ss->is_overlay_screen_set()) {
-    ss->set_overlay_screen<DebugScreen>();
-  }
-  ss->get_shared_data().outputs.push_back("Reset Stack.");
-  return 0;
-}
-
-// No args.
-duk_ret_t js_clear_stack(duk_context *ctx) {
-  ScreenStack *ss = get_js_screen_stack(ctx);
-  ss->clear_screens();
-  ss->get_shared_data().outputs.push_back("Cleared Stack.");
-  return 0;
-}
-
 // "N" args.
 duk_ret_t js_generic_print(duk_context *ctx) {
   ScreenStack *ss = get_js_screen_stack(ctx);
@@ -325,31 +705,6 @@ duk_ret_t js_generic_print(duk_context *ctx) {
   return 0;
 }
 
-// 1 arg.
-duk_ret_t js_get_flag(duk_context *ctx) {
-  ScreenStack *ss = get_js_screen_stack(ctx);
-
-  int top = duk_get_top(ctx);
-  if (top != 1) {
-    ss->get_shared_data().outputs.push_back(
-        "Not 1 arg! usage: get_flag(\"name\") returns boolean");
-    return 0;
-  } else if (!duk_is_string(ctx, 0)) {
-    ss->get_shared_data().outputs.push_back(
-        "1st arg not string! usage: get_flag(\"name\") returns boolean");
-    return 0;
-  }
-  const char *name = duk_get_string(ctx, 0);
-  auto result = ss->get_shared_data().get_flag(name);
-
-  if (result.has_value() && result.value()) {
-    duk_push_boolean(ctx, 1);
-  } else {
-    duk_push_boolean(ctx, 0);
-  }
-  return 1;
-}
-
 duk_ret_t js_print_flags(duk_context *ctx) {
   ScreenStack *ss = get_js_screen_stack(ctx);
 
@@ -371,150 +726,467 @@ duk_ret_t js_print_flags(duk_context *ctx) {
   return 0;
 }
 
-// 2 args.
-duk_ret_t js_set_flag(duk_context *ctx) {
+// 0 or 1 args.
+duk_ret_t js_get_frame_stats(duk_context *ctx) {
   ScreenStack *ss = get_js_screen_stack(ctx);
 
   int top = duk_get_top(ctx);
-  if (top != 2) {
+  std::optional<FrameTimes::Part> part = FrameTimes::Part::TOTAL;
+  if (top > 1) {
     ss->get_shared_data().outputs.push_back(
-        "Not 2 args! usage: set_flag(\"name\", boolean) returns prev boolean");
-    return 0;
-  } else if (!duk_is_string(ctx, 0)) {
-    ss->get_shared_data().outputs.push_back(
-        "1st arg not string! usage: set_flag(\"name\", boolean) returns prev "
-        "boolean");
-    return 0;
-  } else if (!duk_is_boolean(ctx, 1)) {
-    ss->get_shared_data().outputs.push_back(
-        "2nd arg not boolean! usage: set_flag(\"name\", boolean) returns prev "
-        "boolean");
+        "Not 0 or 1 args! usage: get_frame_stats([\"part\"]) returns object");
     return 0;
+  } else if (top == 1 && !duk_is_undefined(ctx, 0)) {
+    if (!duk_is_string(ctx, 0)) {
+      ss->get_shared_data().outputs.push_back(
+          "1st arg not string! usage: get_frame_stats([\"part\"]) returns "
+          "object");
+      return 0;
+    }
+    part = FrameTimes::part_from_name(duk_get_string(ctx, 0));
+    if (!part.has_value()) {
+      ss->get_shared_data().outputs.push_back(
+          "get_frame_stats(...) part must be \"update\", \"draw\", "
+          "\"present\", or \"total\"!");
+      return 0;
+    }
   }
 
-  const char *name = duk_to_string(ctx, 0);
-  auto b = duk_to_boolean(ctx, 1);
-  auto result = ss->get_shared_data().set_flag_lua(name, b != 0);
+  auto stats = ss->get_shared_data().frame_times.get_stats(part.value());
+  // +1
+  duk_push_object(ctx);
+  // +1
+  duk_push_number(ctx, stats.p50);
+  // -1
+  duk_put_prop_string(ctx, -2, "p50");
+  // +1
+  duk_push_number(ctx, stats.p95);
+  // -1
+  duk_put_prop_string(ctx, -2, "p95");
+  // +1
+  duk_push_number(ctx, stats.p99);
+  // -1
+  duk_put_prop_string(ctx, -2, "p99");
+  // +1
+  duk_push_number(ctx, stats.max);
+  // -1
+  duk_put_prop_string(ctx, -2, "max");
+  return 1;
+}
 
-  if (!result.has_value()) {
-    ss->get_shared_data().outputs.push_back("set_flag(...) invalid name!");
-    return 0;
-  } else {
-    duk_push_boolean(ctx, result.value() ? 1 : 0);
-    return 1;
+PoolAllocator *get_js_allocator(duk_context *ctx) {
+  duk_memory_functions functions;
+  duk_get_memory_functions(ctx, &functions);
+  return static_cast<PoolAllocator *>(functions.udata);
+}
+
+// No args.
+duk_ret_t js_get_memory_stats(duk_context *ctx) {
+  auto stats = get_js_allocator(ctx)->get_stats();
+  // +1
+  duk_push_object(ctx);
+  const std::pair<const char *, std::size_t> fields[] = {
+      {"in_use", stats.in_use},
+      {"peak", stats.peak},
+      {"reserved", stats.reserved},
+      {"allocs_last_frame", stats.allocs_last_frame},
+      {"allocs_total", stats.allocs_total},
+      {"limit", stats.limit}};
+  for (const auto &[name, value] : fields) {
+    // +1
+    duk_push_number(ctx, (double)value);
+    // -1
+    duk_put_prop_string(ctx, -2, name);
   }
+  return 1;
 }
 
-// 1 arg.
-duk_ret_t js_toggle_flag(duk_context *ctx) {
-  ScreenStack *ss = get_js_screen_stack(ctx);
+constexpr const char *const duktape_stash_tick_hooks = "tick_hooks";
+constexpr const char *const duktape_stash_tick_next = "tick_next";
 
-  int top = duk_get_top(ctx);
-  if (top != 1) {
-    ss->get_shared_data().outputs.push_back(
-        "Not 1 arg! usage: toggle_flag(\"name\") returns boolean");
-    return 0;
-  } else if (!duk_is_string(ctx, 0)) {
-    ss->get_shared_data().outputs.push_back(
-        "1st arg not string! usage: toggle_flag(\"name\") returns boolean");
+// 1 arg.
+duk_ret_t js_on_tick(duk_context *ctx) {
+  if (!duk_is_function(ctx, 0)) {
+    get_js_screen_stack(ctx)->get_shared_data().outputs.push_back(
+        "usage: on_tick(function(dt) { ... })");
     return 0;
   }
 
-  const char *name = duk_get_string(ctx, 0);
-  auto result = ss->get_shared_data().toggle_flag_lua(name);
+  // +1
+  duk_push_global_stash(ctx);
+  // +1
+  duk_get_prop_string(ctx, -1, duktape_stash_tick_hooks);
+  // +1
+  duk_push_object(ctx);
+  // +1
+  duk_dup(ctx, 0);
+  // -1
+  duk_put_prop_string(ctx, -2, "fn");
+  // -1
+  duk_put_prop_index(ctx, -2, (duk_uarridx_t)duk_get_length(ctx, -2));
+  // -2
+  duk_pop_2(ctx);
+  return 0;
+}
 
-  if (!result.has_value()) {
-    ss->get_shared_data().outputs.push_back("toggle_flag(...) invalid name!");
+// No args.
+duk_ret_t js_clear_ticks(duk_context *ctx) {
+  // +1
+  duk_push_global_stash(ctx);
+  // +1
+  duk_push_array(ctx);
+  // -1
+  duk_put_prop_string(ctx, -2, duktape_stash_tick_hooks);
+  // -1
+  duk_pop(ctx);
+  return 0;
+}
+
+// 2 args. Fills the caller's array with x, y, z, vx, vy, vz, so reusing one
+// array doesn't allocate.
+duk_ret_t js_get_sphere(duk_context *ctx) {
+  auto &shared = get_js_screen_stack(ctx)->get_shared_data();
+
+  if (!duk_is_number(ctx, 0) || !duk_is_array(ctx, 1)) {
+    shared.outputs.push_back("usage: get_sphere(idx, out_array)");
     return 0;
-  } else {
-    duk_push_boolean(ctx, result.value() ? 1 : 0);
+  }
+  double idx = duk_get_number(ctx, 0);
+  if (!(idx >= 0.0 && idx < (double)shared.combatants.size())) {
+    // +1
+    duk_push_false(ctx);
     return 1;
   }
+
+  const auto &c = shared.combatants[(std::size_t)idx];
+  duk_uarridx_t out_idx = 0;
+  for (float value : {c.x, c.y, c.z, c.vx, c.vy, c.vz}) {
+    // +1
+    duk_push_number(ctx, value);
+    // -1
+    duk_put_prop_index(ctx, 1, out_idx++);
+  }
+  // +1
+  duk_push_true(ctx);
+  return 1;
 }
 
-// No args.
-duk_ret_t js_print_known_flags(duk_context *ctx) {
-  ScreenStack *ss = get_js_screen_stack(ctx);
+/// Thrown by Duktape once gander_duk_exec_timeout() returns true.
+constexpr const char *const duktape_exec_timeout_message = "execution timeout";
 
-  auto flags = ss->get_known_flags();
-  ss->get_shared_data().outputs.push_back("  Known flags:");
-  for (const auto &flag : flags) {
-    ss->get_shared_data().outputs.push_back(flag);
+// Whether the error at "idx" is Duktape aborting the script, rather than one
+// the script threw.
+bool js_is_exec_timeout(duk_context *ctx, duk_idx_t idx) {
+  idx = duk_normalize_index(ctx, idx);
+  if (duk_get_error_code(ctx, idx) != DUK_ERR_RANGE_ERROR) {
+    return false;
   }
-
-  return 0;
+  // +1
+  duk_get_prop_string(ctx, idx, "message");
+  const char *message = duk_get_string(ctx, -1);
+  bool timed_out =
+      message && std::strcmp(message, duktape_exec_timeout_message) == 0;
+  // -1
+  duk_pop(ctx);
+  return timed_out;
 }
 
-// No args.
-duk_ret_t js_get_help(duk_context *ctx) {
-  ScreenStack *ss = get_js_screen_stack(ctx);
+// Calls the on_tick() hooks round-robin until script_deadline. Hooks not
+// reached continue next frame. One that runs past the deadline is aborted by
+// gander_duk_exec_timeout() and removed: Duktape can't suspend it like Lua
+// yields, and re-running it would repeat what it did before the abort.
+void js_run_tick_hooks(duk_context *ctx, float dt) {
+  auto &shared = get_js_global_screen_stack(ctx)->get_shared_data();
+
+  // +1
+  duk_push_global_stash(ctx);
+  // +1
+  duk_get_prop_string(ctx, -1, duktape_stash_tick_hooks);
+  duk_uarridx_t count = (duk_uarridx_t)duk_get_length(ctx, -1);
+  // +1
+  duk_get_prop_string(ctx, -2, duktape_stash_tick_next);
+  duk_uarridx_t next = (duk_uarridx_t)duk_get_uint(ctx, -1);
+  // -1
+  duk_pop(ctx);
 
-  ss->get_shared_data().outputs.push_back("  Functions:");
-  ss->get_shared_data().outputs.push_back("help()");
-  ss->get_shared_data().outputs.push_back("print_known_flags()");
-  ss->get_shared_data().outputs.push_back("toggle_flag(\"name\")");
-  ss->get_shared_data().outputs.push_back("get_flag(\"name\")");
-  ss->get_shared_data().outputs.push_back("print_flags(\"name\", ...)");
-  ss->get_shared_data().outputs.push_back("set_flag(\"name\", boolean)");
-  ss->get_shared_data().outputs.push_back("gen_print(...)");
-  ss->get_shared_data().outputs.push_back("reset_stack()");
-  ss->get_shared_data().outputs.push_back("clear_stack()");
+  duk_uarridx_t ran = 0;
+  for (; ran < count && !script_expired(); ++ran) {
+    duk_uarridx_t idx = (next + ran) % count;
+    if (js_active_profiler) {
+      js_active_profiler->set_entry("on_tick() hook", idx);
+    }
+    // +1
+    duk_get_prop_index(ctx, -1, idx);
+    // +1
+    duk_get_prop_string(ctx, -1, "fn");
+    // +1
+    duk_push_number(ctx, dt);
+    // -2, +1
+    if (duk_pcall(ctx, 1) == DUK_EXEC_SUCCESS) {
+      // -2
+      duk_pop_2(ctx);
+      continue;
+    }
 
-  return 0;
+    if (js_is_exec_timeout(ctx, -1)) {
+      shared.outputs.push_back(std::format(
+          "Removed tick hook {}, it ran past the frame's {} ms budget", idx,
+          SCRIPT_TICK_BUDGET * 1000.0));
+    } else {
+      shared.outputs.push_back(std::format("Removed tick hook {}: {}", idx,
+                                           duk_safe_to_string(ctx, -1)));
+    }
+    // -2
+    duk_pop_2(ctx);
+
+    // Remove the failed hook, the ones after it shift down.
+    for (duk_uarridx_t i = idx; i + 1 < count; ++i) {
+      // +1
+      duk_get_prop_index(ctx, -1, i + 1);
+      // -1
+      duk_put_prop_index(ctx, -2, i);
+    }
+    --count;
+    // +1
+    duk_push_uint(ctx, count);
+    // -1
+    duk_put_prop_string(ctx, -2, "length");
+    next = idx;
+    ran = 0;
+    break;
+  }
+
+  // +1
+  duk_push_uint(ctx, count > 0 ? (next + ran) % count : 0);
+  // -1
+  duk_put_prop_string(ctx, -3, duktape_stash_tick_next);
+  // -2
+  duk_pop_2(ctx);
 }
 
-// Helper to set screen-stack-ptr and register c_func.
-void js_register_c_func(duk_context *ctx, duk_ret_t (*c_func)(duk_context *ctx),
-                        duk_idx_t nargs, const char *name) {
+// 1 optional arg. With an object, sets each of its own properties to that
+// flag's value (false if unknown) and returns it, so one object can be
+// reused. Without, returns a new object of every flag.
+duk_ret_t js_get_flags(duk_context *ctx) {
+  auto &shared = get_js_screen_stack(ctx)->get_shared_data();
+
+  if (duk_is_undefined(ctx, 0)) {
+    // +1
+    duk_push_object(ctx);
+    for (const auto &[name, value] : shared.flags) {
+      // +1
+      duk_push_boolean(ctx, value);
+      // -1
+      duk_put_prop_lstring(ctx, -2, name.data(), name.size());
+    }
+    return 1;
+  } else if (!duk_is_object(ctx, 0)) {
+    shared.outputs.push_back("usage: get_flags([object]) returns object");
+    return 0;
+  }
+
   // +1
-  duk_push_c_function(ctx, c_func, nargs);
+  duk_enum(ctx, 0, DUK_ENUM_OWN_PROPERTIES_ONLY);
+  // +1 while true.
+  while (duk_next(ctx, -1, 0)) {
+    duk_size_t size = 0;
+    const char *name = duk_get_lstring(ctx, -1, &size);
+    auto iter = shared.flags.find(std::string_view(name, size));
+    // +1
+    duk_push_boolean(ctx, iter != shared.flags.end() && iter->second);
+    // -2
+    duk_put_prop(ctx, 0);
+  }
   // -1
-  duk_put_global_string(ctx, name);
+  duk_pop(ctx);
+  // +1
+  duk_dup(ctx, 0);
+  return 1;
+}
+
+// 1 arg. Sets every existing flag named in the object, like set_flag().
+duk_ret_t js_set_flags(duk_context *ctx) {
+  auto &shared = get_js_screen_stack(ctx)->get_shared_data();
+
+  if (!duk_is_object(ctx, 0)) {
+    shared.outputs.push_back("usage: set_flags({name: boolean, ...})");
+    return 0;
+  }
+
+  unsigned int invalid = 0;
+  // +1
+  duk_enum(ctx, 0, DUK_ENUM_OWN_PROPERTIES_ONLY);
+  // +2 while true.
+  while (duk_next(ctx, -1, 1)) {
+    duk_size_t size = 0;
+    const char *name = duk_get_lstring(ctx, -2, &size);
+    if (auto iter = shared.flags.find(std::string_view(name, size));
+        iter != shared.flags.end() && duk_is_boolean(ctx, -1)) {
+      iter->second = duk_get_boolean(ctx, -1);
+    } else {
+      ++invalid;
+    }
+    // -2
+    duk_pop_2(ctx);
+  }
+  // -1
+  duk_pop(ctx);
+
+  if (invalid != 0) {
+    shared.outputs.push_back(
+        std::format("set_flags(...) skipped {} invalid entries", invalid));
+  }
+  return 0;
+}
+
+// Checked by Duktape's executor every so many instructions, see
+// DUK_USE_EXEC_TIMEOUT_CHECK in duk_config.h.
+extern "C" duk_bool_t gander_duk_exec_timeout(void *) {
+  if (js_active_profiler) {
+    js_active_profiler->add_entry_sample();
+  }
+  return script_expired() ? 1 : 0;
 }
 
 // #############################################################################
 // END Duktape/JS stuff
 // #############################################################################
 
+/// Registered in both engines, in the order help() lists them.
+constexpr ScriptBinding script_bindings[] = {
+    script_binding<&script_get_help>("help", "help()"),
+    script_binding<&script_print_known_flags>("print_known_flags",
+                                              "print_known_flags()"),
+    script_binding<&script_toggle_flag>("toggle_flag", "toggle_flag(\"name\")"),
+    script_binding<&script_get_flag>("get_flag", "get_flag(\"name\")"),
+    engine_binding<lua_print_flags, js_print_flags>(
+        "print_flags", DUK_VARARGS, "print_flags(\"name\", ...)"),
+    script_binding<&script_set_flag>("set_flag",
+                                     "set_flag(\"name\", boolean)"),
+    engine_binding<lua_get_flags, js_get_flags>(
+        "get_flags", 1, "get_flags([table])", "get_flags([object])"),
+    engine_binding<lua_set_flags, js_set_flags>(
+        "set_flags", 1, "set_flags({name = boolean, ...})",
+        "set_flags({name: boolean, ...})"),
+    engine_binding<lua_generic_print, js_generic_print>(
+        "gen_print", DUK_VARARGS, "gen_print(...)"),
+    script_binding<&script_reset_stack>("reset_stack", "reset_stack()"),
+    script_binding<&script_clear_stack>("clear_stack", "clear_stack()"),
+    engine_binding<lua_get_frame_stats, js_get_frame_stats>(
+        "get_frame_stats", DUK_VARARGS, "get_frame_stats([\"part\"])"),
+    script_binding<&script_print_frame_stats>("print_frame_stats",
+                                              "print_frame_stats()"),
+    engine_binding<lua_get_memory_stats, js_get_memory_stats>(
+        "get_memory_stats", 0, "get_memory_stats()"),
+    script_binding<&script_set_memory_limit>(
+        "set_memory_limit", "set_memory_limit(bytes), 0 for unlimited"),
+    script_binding<&script_print_vm_memory>("print_vm_memory",
+                                            "print_vm_memory()"),
+    script_binding<&script_profile_start>("profile_start", "profile_start()"),
+    script_binding<&script_profile_stop>("profile_stop", "profile_stop()"),
+    script_binding<&script_profile_report>("profile_report",
+                                           "profile_report([count])"),
+    engine_binding<lua_on_tick, js_on_tick>("on_tick", 1,
+                                            "on_tick(function(dt) ... end)",
+                                            "on_tick(function(dt) { ... })"),
+    engine_binding<lua_clear_ticks, js_clear_ticks>("clear_ticks", 0,
+                                                    "clear_ticks()"),
+    script_binding<&script_get_sphere_count>("get_sphere_count",
+                                             "get_sphere_count()"),
+    engine_binding<lua_get_sphere, js_get_sphere>(
+        "get_sphere", 2, "get_sphere(idx) -> x,y,z,vx,vy,vz",
+        "get_sphere(idx, out_array)"),
+};
+
+void script_get_help(ScriptEnv &env) {
+  auto &outputs = env.ss->get_shared_data().outputs;
+  outputs.push_back("  Functions:");
+  for (const auto &binding : script_bindings) {
+    outputs.push_back(env.engine == ScriptEngine::LUA ? binding.lua_usage
+                                                      : binding.js_usage);
+  }
+  // Defined by the boot scripts.
+  outputs.push_back("print_spheres()");
+}
+
 DebugScreen::DebugScreen(std::weak_ptr<ScreenStack> stack)
     : Screen(stack),
-      embedded_state(),
+      lua_allocator(POOL_SIZE_CLASSES_LUA),
+      js_allocator(POOL_SIZE_CLASSES_DUK),
+      lua_state(nullptr),
+      js_state(nullptr),
+      script_cache(),
+      lua_profiler(),
+      js_profiler(),
+      lua_env{stack.lock().get(), &lua_allocator, &js_allocator, &lua_profiler,
+              ScriptEngine::LUA},
+      js_env{stack.lock().get(), &js_allocator, &lua_allocator, &js_profiler,
+             ScriptEngine::JS},
+      script_thread(),
       flags(),
       shared(&stack.lock()->get_shared_data()),
       console{"Use \"help()\" for available functions."s},
       console_current("> "s),
+      console_texture(),
+      console_current_width(0.0F),
       console_x_offset(0),
+      console_scroll(0),
       history_idx(std::nullopt),
-      fps_enabled_cache(true) {
-  flags.reset(1);
+      fps_enabled_cache(true),
+      frame_times_enabled_cache(false) {
+  StartupTrace::Scope scope("DebugScreen");
 
-  initialize_lua_state();
+  // Lua, but not created until ensure_embedded_state().
+  flags.set(0);
+  flags.set(2);
+
+  set_console_current("> "s);
 
   shared->init_flag(enable_fps_flag, true);
+#ifndef NDEBUG
+  shared->init_flag(prewarm_scripting_flag, true);
+#else
+  shared->init_flag(prewarm_scripting_flag, false);
+#endif
 }
 
-DebugScreen::~DebugScreen() { cleanup_embedded_state(); }
+DebugScreen::~DebugScreen() {
+  if (console_texture) {
+    UnloadRenderTexture(*console_texture);
+  }
+  cleanup_embedded_state();
+}
 
 bool DebugScreen::update(float dt, bool screen_resized) {
+  // Answers the running console line before its outputs are printed below.
+  script_thread.service(SCRIPT_THREAD_SERVICE_BUDGET);
+  bool script_running = script_thread.is_busy();
+  if (!script_running || !flags.test(1)) {
+    lua_allocator.new_frame();
+  }
+  if (!script_running || flags.test(1)) {
+    js_allocator.new_frame();
+  }
+
   bool just_enabled = false;
   if (IsKeyPressed(KEY_GRAVE) && !IsKeyDown(KEY_LEFT_SHIFT) &&
       !IsKeyDown(KEY_RIGHT_SHIFT)) {
     just_enabled = shared->toggle_flag(enable_console_flag);
+    if (just_enabled) {
+      ensure_embedded_state();
+    }
   }
 
   if (auto optb = shared->get_flag(enable_console_flag);
       optb.has_value() && optb.value()) {
     for (auto output : shared->outputs) {
-      console.push_back(output);
+      push_console(std::move(output));
     }
     shared->outputs.clear();
     if (IsKeyPressed(KEY_BACKSPACE)) {
-      if (console_current.size() > 2) {
-        console_current.pop_back();
-        console_x_offset = std::nullopt;
-      }
+      pop_console_current();
     } else if (IsKeyPressed(KEY_ENTER)) {
-      console.push_back(console_current);
+      push_console(console_current);
 
       if (console_current.size() > 2) {
         if (history.empty() || history.front() != console_current) {
@@ -524,66 +1196,59 @@ bool DebugScreen::update(float dt, bool screen_resized) {
           }
         }
         history_idx = std::nullopt;
-        if (flags.test(0)) {
-          // +1
-          int result =
-              luaL_loadstring(get_lua_state(), console_current.c_str() + 2);
-          if (result != LUA_OK) {
-            console.push_back(lua_tostring(get_lua_state(), -1));
-            // -1
-            lua_pop(get_lua_state(), 1);
-          } else {
-            // -1, +1 on error.
-            result = lua_pcall(get_lua_state(), 0, 0, 0);
-            if (result != LUA_OK) {
-              console.push_back(lua_tostring(get_lua_state(), -1));
-              // -1
-              lua_pop(get_lua_state(), 1);
-            }
-          }
+        if (script_running) {
+          push_console("Still running the previous line."s);
         } else {
-          // +1
-          duk_push_string(get_js_state(), console_current.c_str() + 2);
-          // +1, -1
-          if (duk_peval(get_js_state()) != 0) {
-            console.push_back(
-                std::format("{}", duk_safe_to_string(get_js_state(), -1)));
-#ifndef NDEBUG
-            std::clog << duk_safe_to_string(get_js_state(), -1) << '\n';
-#endif
+          // The console may have been enabled by a flag instead of the key.
+          ensure_embedded_state();
+          flags.set(1, flags.test(0));
+          if (flags.test(0)) {
+            script_thread.start([this, source = console_current.substr(2)] {
+              run_console_lua(source);
+            });
           } else {
-            /* console.push_back(std::format("{}",
-             * duk_safe_to_string(get_js_state(), -1)));*/
+            script_thread.start([this, source = console_current.substr(2)] {
+              run_console_js(source);
+            });
           }
-          // -1
-          duk_pop(get_js_state());
         }
       } else {
-        console.push_back("Empty input."s);
+        push_console("Empty input."s);
       }
 
-      console_current = "> "s;
-      console_x_offset = std::nullopt;
-      while (console.size() > 25) {
-        // Limit size of history.
-        console.pop_front();
-      }
+      set_console_current("> "s);
+      console_scroll = 0;
     } else if (IsKeyPressed(KEY_UP)) {
       if (history_idx.has_value()) {
         history_idx = history_idx.value() + 1;
         if (history_idx.value() >= history.size()) {
           history_idx = history_idx.value() - 1;
         } else {
-          console_current = history[history_idx.value()];
+          set_console_current(history[history_idx.value()]);
         }
       } else if (!history.empty()) {
         history_idx = 0;
-        console_current = history[0];
+        set_console_current(history[0]);
       }
     } else if (IsKeyPressed(KEY_DOWN)) {
       if (history_idx.has_value() && history_idx.value() > 0) {
         history_idx = history_idx.value() - 1;
-        console_current = history[history_idx.value()];
+        set_console_current(history[history_idx.value()]);
+      }
+    } else if (IsKeyPressed(KEY_PAGE_UP)) {
+      if (console.size() > console_scroll + CONSOLE_VISIBLE_LINES) {
+        console_scroll += CONSOLE_VISIBLE_LINES;
+        if (console_scroll >= console.size()) {
+          console_scroll = (unsigned int)console.size() - 1;
+        }
+        flags.set(2);
+      }
+    } else if (IsKeyPressed(KEY_PAGE_DOWN)) {
+      if (console_scroll > 0) {
+        console_scroll = console_scroll > CONSOLE_VISIBLE_LINES
+                             ? console_scroll - CONSOLE_VISIBLE_LINES
+                             : 0;
+        flags.set(2);
       }
     }
 
@@ -592,62 +1257,93 @@ bool DebugScreen::update(float dt, bool screen_resized) {
       c = GetCharPressed();
       if (just_enabled && c == '`') {
       } else if (c != 0 && c < 128) {
-        console_current.push_back((char)c);
-        console_x_offset = std::nullopt;
+        push_console_current((char)c);
       }
     } while (c != 0);
-
-    if (!console_x_offset.has_value()) {
-      auto text_width = MeasureText(console_current.c_str(), 20);
-      if (text_width + 5 > SCREEN_WIDTH) {
-        console_x_offset = SCREEN_WIDTH - 5 - text_width;
-      } else {
-        console_x_offset = 0;
-      }
-    }
   }
 
   // TODO: Maybe set up a way to not get this every frame?
   fps_enabled_cache = shared->get_flag(enable_fps_flag).value();
+  frame_times_enabled_cache = shared->get_flag(frame_times_flag).value();
 
   {
     auto toggle_embedded = shared->get_flag(toggle_embedded_flag);
     if (toggle_embedded.has_value() && toggle_embedded.value()) {
       shared->set_flag(toggle_embedded_flag, false);
-      if (flags.test(0)) {
-        initialize_js_state();
-        flags.reset(0);
-      } else {
-        initialize_lua_state();
-        flags.set(0);
+      flags.flip(0);
+      // Once scripting is in use, the newly selected state is created now
+      // instead of on the next console line.
+      if (lua_state || js_state) {
+        ensure_embedded_state();
+        shared->outputs.push_back(flags.test(0) ? "Console input goes to Lua"s
+                                                : "Console input goes to JS"s);
+        // The running line's allocator is its thread's.
+        if (!script_thread.is_busy()) {
+          print_vm_memory(*shared, lua_allocator, js_allocator);
+        }
       }
     }
   }
 
+  if (lua_state || js_state) {
+    // A state running a console line skips its hooks until it is done.
+    script_running = script_thread.is_busy();
+    bool lua_ready = lua_state && !(script_running && flags.test(1));
+    bool js_ready = js_state && !(script_running && !flags.test(1));
+
+    // Both states' hooks share the budget, the selected one's run first.
+    script_deadline = GetTime() + SCRIPT_TICK_BUDGET;
+    if (lua_ready && flags.test(0)) {
+      lua_run_tick_hooks(lua_state, dt);
+    }
+    if (js_ready) {
+      js_run_tick_hooks(js_state, dt);
+    }
+    if (lua_ready && !flags.test(0)) {
+      lua_run_tick_hooks(lua_state, dt);
+    }
+    script_deadline = 0.0;
+  }
+
+  if (!lua_state && !js_state && dt < SCRIPT_PREWARM_IDLE_DT &&
+      StartupTrace::is_finished()) {
+    if (auto prewarm = shared->get_flag(prewarm_scripting_flag);
+        prewarm.has_value() && prewarm.value()) {
+      ensure_embedded_state();
+    }
+  }
+
   auto optb = shared->get_flag(enable_console_flag);
   return !(optb.has_value() && optb.value());
 }
 
 bool DebugScreen::draw(RenderTexture *render_texture) {
+  bool console_enabled;
+  {
+    auto optb = shared->get_flag(enable_console_flag);
+    console_enabled = optb.has_value() && optb.value();
+  }
+
+  if (console_enabled && flags.test(2)) {
+    // Must be done outside of BeginTextureMode(*render_texture).
+    redraw_console_texture();
+  }
+
   BeginTextureMode(*render_texture);
 
-  if (auto optb = shared->get_flag(enable_console_flag);
-      optb.has_value() && optb.value()) {
+  if (console_enabled) {
     DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, Color{0, 0, 0, 64});
-
-    int offset_y = 24;
-    DrawText(console_current.c_str(), 5 + console_x_offset.value(),
-             SCREEN_HEIGHT - offset_y, 20, RAYWHITE);
-    offset_y += 24;
-    for (auto riter = console.crbegin(); riter != console.crend(); ++riter) {
-      DrawText(riter->c_str(), 5, SCREEN_HEIGHT - offset_y, 20, RAYWHITE);
-      offset_y += 24;
-    }
+    DrawTextureRec(console_texture->texture,
+                   Rectangle{0, 0, (float)SCREEN_WIDTH, (float)-SCREEN_HEIGHT},
+                   {0, 0}, WHITE);
   } else {
     if (fps_enabled_cache) {
       std::string draw_text = std::to_string(GetFPS());
       DrawText(draw_text.c_str(), 10, 10, 30, RAYWHITE);
     }
+    if (frame_times_enabled_cache) {
+      draw_frame_times();
+    }
   }
 
   EndTextureMode();
@@ -655,25 +1351,178 @@ bool DebugScreen::draw(RenderTexture *render_texture) {
 }
 
 std::list<std::string> DebugScreen::get_known_flags() const {
-  return {enable_console_flag, enable_fps_flag, toggle_embedded_flag};
+  return {enable_console_flag, enable_fps_flag, toggle_embedded_flag,
+          frame_times_flag, prewarm_scripting_flag};
 }
 
-void DebugScreen::cleanup_embedded_state() {
-  if (flags.test(1)) {
-    if (flags.test(0)) {
-      lua_close(get_lua_state());
-    } else {
-      duk_destroy_heap(get_js_state());
+void DebugScreen::push_console(std::string line) {
+  console.push_back(std::move(line));
+  while (console.size() > CONSOLE_SCROLLBACK_MAX) {
+    console.pop_front();
+  }
+  // Keep the scrolled-to lines in view as new ones arrive.
+  if (console_scroll > 0 && console_scroll + 1 < console.size()) {
+    ++console_scroll;
+  }
+  flags.set(2);
+}
+
+void DebugScreen::set_console_current(std::string line) {
+  console_current = std::move(line);
+  console_current_width =
+      MeasureTextEx(GetFontDefault(), console_current.c_str(),
+                    CONSOLE_FONT_SIZE, CONSOLE_FONT_SPACING)
+          .x;
+  update_console_x_offset();
+}
+
+void DebugScreen::push_console_current(char c) {
+  console_current.push_back(c);
+  // A line's width is the sum of its glyphs' widths, plus spacing between
+  // each glyph.
+  console_current_width += console_glyph_width(c) + CONSOLE_FONT_SPACING;
+  update_console_x_offset();
+}
+
+void DebugScreen::pop_console_current() {
+  if (console_current.size() > 2) {
+    console_current_width -=
+        console_glyph_width(console_current.back()) + CONSOLE_FONT_SPACING;
+    console_current.pop_back();
+    update_console_x_offset();
+  }
+}
+
+float DebugScreen::console_glyph_width(char c) {
+  const char glyph[2] = {c, 0};
+  return MeasureTextEx(GetFontDefault(), glyph, CONSOLE_FONT_SIZE,
+                       CONSOLE_FONT_SPACING)
+      .x;
+}
+
+void DebugScreen::update_console_x_offset() {
+  int text_width = (int)console_current_width;
+  if (text_width + 5 > SCREEN_WIDTH) {
+    console_x_offset = SCREEN_WIDTH - 5 - text_width;
+  } else {
+    console_x_offset = 0;
+  }
+  flags.set(2);
+}
+
+void DebugScreen::redraw_console_texture() {
+  if (!console_texture) {
+    console_texture = std::make_unique<RenderTexture>(
+        LoadRenderTexture(SCREEN_WIDTH, SCREEN_HEIGHT));
+  }
+
+  BeginTextureMode(*console_texture);
+  ClearBackground(BLANK);
+
+  int offset_y = 24;
+  DrawText(console_current.c_str(), 5 + console_x_offset,
+           SCREEN_HEIGHT - offset_y, (int)CONSOLE_FONT_SIZE, RAYWHITE);
+  offset_y += 24;
+  // Only the lines on screen are drawn, so long scrollback costs nothing.
+  for (auto riter = console.crbegin() + console_scroll;
+       riter != console.crend() && offset_y <= SCREEN_HEIGHT; ++riter) {
+    DrawText(riter->c_str(), 5, SCREEN_HEIGHT - offset_y,
+             (int)CONSOLE_FONT_SIZE, RAYWHITE);
+    offset_y += 24;
+  }
+
+  EndTextureMode();
+  flags.reset(2);
+}
+
+void DebugScreen::draw_frame_times() {
+  const auto &frame_times = shared->frame_times;
+  const int bottom = FRAME_GRAPH_Y + FRAME_GRAPH_HEIGHT;
+
+  DrawRectangle(FRAME_GRAPH_X, FRAME_GRAPH_Y, (int)FRAME_TIMES_SIZE,
+                FRAME_GRAPH_HEIGHT, Color{0, 0, 0, 128});
+
+  // Stacked update, draw, and present times of each frame, newest on the
+  // right.
+  const auto size = frame_times.size();
+  for (std::size_t idx = 0; idx < size; ++idx) {
+    int x = FRAME_GRAPH_X + (int)(FRAME_TIMES_SIZE - size + idx);
+    int y = bottom;
+    for (auto [part, color] :
+         {std::pair{FrameTimes::Part::UPDATE, SKYBLUE},
+          std::pair{FrameTimes::Part::DRAW, ORANGE},
+          std::pair{FrameTimes::Part::PRESENT, LIGHTGRAY}}) {
+      int height = (int)(frame_times.get(part, idx) * FRAME_GRAPH_PX_PER_MS);
+      if (y - height < FRAME_GRAPH_Y) {
+        height = y - FRAME_GRAPH_Y;
+      }
+      if (height > 0) {
+        DrawLine(x, y, x, y - height, color);
+        y -= height;
+      }
     }
-    flags.reset(1);
   }
+
+  // Mark 60 fps.
+  int y_60 = bottom - (int)(1000.0F / 60.0F * FRAME_GRAPH_PX_PER_MS);
+  DrawLine(FRAME_GRAPH_X, y_60, FRAME_GRAPH_X + (int)FRAME_TIMES_SIZE, y_60,
+           GREEN);
+
+  auto stats = frame_times.get_stats(FrameTimes::Part::TOTAL);
+  std::string text =
+      std::format("p50 {:.1f} p95 {:.1f} p99 {:.1f} max {:.1f} ms", stats.p50,
+                  stats.p95, stats.p99, stats.max);
+  DrawText(text.c_str(), FRAME_GRAPH_X, bottom + 4, 10, RAYWHITE);
 }
 
-void DebugScreen::initialize_lua_state() {
-  cleanup_embedded_state();
+void DebugScreen::cleanup_embedded_state() {
+  // Aborts a running console line, see script_expired().
+  script_thread.finish();
+  if (lua_active_profiler == &lua_profiler) {
+    lua_profiler.stop();
+    lua_active_profiler = nullptr;
+  }
+  if (js_active_profiler == &js_profiler) {
+    js_profiler.stop();
+    js_active_profiler = nullptr;
+  }
+  if (lua_state) {
+    lua_close(lua_state);
+    lua_state = nullptr;
+    lua_allocator.release_unused();
+  }
+  if (js_state) {
+    duk_destroy_heap(js_state);
+    js_state = nullptr;
+    js_allocator.release_unused();
+  }
+}
 
-  embedded_state = lua_newstate(alloc_for_lua, stack.lock().get(), 0x1234);
-  flags.set(0);
+void DebugScreen::ensure_embedded_state() {
+  if (flags.test(0) ? lua_state != nullptr : js_state != nullptr) {
+    return;
+  }
+
+  StartupTrace::Scope scope("Scripting state");
+  double start = GetTime();
+  if (flags.test(0)) {
+    initialize_lua_state();
+    int kib = lua_gc(get_lua_state(), LUA_GCCOUNT);
+    int bytes = lua_gc(get_lua_state(), LUA_GCCOUNTB);
+    shared->outputs.push_back(std::format(
+        "Lua state took {:.2f} ms and {:.1f} KiB", (GetTime() - start) * 1000.0,
+        (double)kib + (double)bytes / 1024.0));
+  } else {
+    initialize_js_state();
+    shared->outputs.push_back(std::format(
+        "Duktape state took {:.2f} ms and {:.1f} KiB",
+        (GetTime() - start) * 1000.0,
+        (double)js_allocator.get_stats().in_use / 1024.0));
+  }
+}
+
+void DebugScreen::initialize_lua_state() {
+  lua_state = lua_newstate(PoolAllocator::lua_alloc, &lua_allocator, 0x1234);
 
   luaL_requiref(get_lua_state(), "string", luaopen_string, 1);
   luaL_requiref(get_lua_state(), "table", luaopen_table, 1);
@@ -687,65 +1536,39 @@ void DebugScreen::initialize_lua_state() {
   // -2
   lua_settable(get_lua_state(), LUA_REGISTRYINDEX);
 
-  // Put "reset_stack()" into global.
-  // +1
-  lua_pushcfunction(get_lua_state(), lua_reset_stack);
-  // -1
-  lua_setglobal(get_lua_state(), "reset_stack");
-
-  // Put "clear_stack()" into global.
-  // +1
-  lua_pushcfunction(get_lua_state(), lua_clear_stack);
-  // -1
-  lua_setglobal(get_lua_state(), "clear_stack");
-
-  // Put "gen_print()" into global.
-  // +1
-  lua_pushcfunction(get_lua_state(), lua_generic_print);
-  // -1
-  lua_setglobal(get_lua_state(), "gen_print");
-
-  // Put flag related fns into global.
-  // +1
-  lua_pushcfunction(get_lua_state(), lua_get_flag);
-  // -1
-  lua_setglobal(get_lua_state(), "get_flag");
-
-  // +1
-  lua_pushcfunction(get_lua_state(), lua_print_flags);
-  // -1
-  lua_setglobal(get_lua_state(), "print_flags");
-
   // +1
-  lua_pushcfunction(get_lua_state(), lua_set_flag);
+  lua_createtable(get_lua_state(), 0, 1);
   // -1
-  lua_setglobal(get_lua_state(), "set_flag");
+  lua_setfield(get_lua_state(), LUA_REGISTRYINDEX, lua_tick_hooks_key);
 
-  // +1
-  lua_pushcfunction(get_lua_state(), lua_toggle_flag);
-  // -1
-  lua_setglobal(get_lua_state(), "toggle_flag");
+  // Coroutines created from here on inherit it.
+  lua_sethook(get_lua_state(), lua_main_hook, LUA_MASKCOUNT,
+              SCRIPT_HOOK_COUNT);
 
-  // +1
-  lua_pushcfunction(get_lua_state(), lua_print_known_flags);
-  // -1
-  lua_setglobal(get_lua_state(), "print_known_flags");
+  register_lua_bindings(get_lua_state(), &lua_env, script_bindings);
 
+  // Precompiled into "data" by ResourcePack.
   // +1
-  lua_pushcfunction(get_lua_state(), lua_get_help);
-  // -1
-  lua_setglobal(get_lua_state(), "help");
-
-  flags.set(1);
+  int result = ScriptCache::load_lua_file(get_lua_state(), LUA_BOOT_SCRIPT);
+  if (result == LUA_OK) {
+    // -1, +1 on error.
+    result = lua_pcall(get_lua_state(), 0, 0, 0);
+  }
+  if (result != LUA_OK) {
+    shared->outputs.push_back(lua_tostring(get_lua_state(), -1));
+    // -1
+    lua_pop(get_lua_state(), 1);
+  }
 
   stack.lock()->get_shared_data().outputs.push_back("Loaded Lua"s);
 }
 
 void DebugScreen::initialize_js_state() {
-  cleanup_embedded_state();
-
-  embedded_state = duk_create_heap_default();
-  flags.reset(0);
+  js_allocator.set_limit(JS_HEAP_LIMIT);
+  // Allocation failures, including past the limit, throw a RangeError.
+  js_state =
+      duk_create_heap(PoolAllocator::duk_alloc, PoolAllocator::duk_realloc,
+                      PoolAllocator::duk_free, &js_allocator, nullptr);
 
   ScreenStack *ss = this->stack.lock().get();
 
@@ -759,34 +1582,72 @@ void DebugScreen::initialize_js_state() {
   // -1
   duk_put_global_string(get_js_state(), duktape_hidden_symbol_ss_object);
 
-  js_register_c_func(get_js_state(), js_reset_stack, 0, "reset_stack");
-  js_register_c_func(get_js_state(), js_clear_stack, 0, "clear_stack");
-  js_register_c_func(get_js_state(), js_generic_print, DUK_VARARGS,
-                     "gen_print");
-  js_register_c_func(get_js_state(), js_get_flag, 1, "get_flag");
-  js_register_c_func(get_js_state(), js_print_flags, DUK_VARARGS,
-                     "print_flags");
-  js_register_c_func(get_js_state(), js_set_flag, 2, "set_flag");
-  js_register_c_func(get_js_state(), js_toggle_flag, 1, "toggle_flag");
-  js_register_c_func(get_js_state(), js_print_known_flags, 0,
-                     "print_known_flags");
-  js_register_c_func(get_js_state(), js_get_help, 0, "help");
-
-  flags.set(1);
+  register_js_bindings(get_js_state(), &js_env, script_bindings);
+
+  // The on_tick() hooks live in the stash, away from scripts.
+  js_clear_ticks(get_js_state());
+
+  // Precompiled into "data" by ResourcePack.
+  // +1
+  int result = ScriptCache::load_js_file(get_js_state(), JS_BOOT_SCRIPT);
+  if (result == DUK_EXEC_SUCCESS) {
+    // -1, +1
+    result = duk_pcall(get_js_state(), 0);
+  }
+  if (result != DUK_EXEC_SUCCESS) {
+    shared->outputs.push_back(duk_safe_to_string(get_js_state(), -1));
+  }
+  // -1
+  duk_pop(get_js_state());
 
   stack.lock()->get_shared_data().outputs.push_back("Loaded Duktape"s);
 }
 
-lua_State *DebugScreen::get_lua_state() {
-  if (flags.test(0)) {
-    return std::get<lua_State *>(embedded_state);
+void DebugScreen::run_console_lua(const std::string &source) {
+  script_deadline = GetTime() + SCRIPT_CONSOLE_TIMEOUT;
+  // Named by its source, like luaL_loadstring().
+  // +1
+  int result = script_cache.load_lua(get_lua_state(), source, source.c_str());
+  if (result == LUA_OK) {
+    // -1, +1 on error.
+    result = lua_pcall(get_lua_state(), 0, 0, 0);
+  }
+  script_deadline = 0.0;
+
+  if (result != LUA_OK) {
+    std::string error = lua_tostring(get_lua_state(), -1);
+    // -1
+    lua_pop(get_lua_state(), 1);
+    script_thread.call_on_render_thread(
+        [this, &error] { push_console(std::move(error)); });
   }
-  return nullptr;
 }
 
-duk_context *DebugScreen::get_js_state() {
-  if (!flags.test(0)) {
-    return std::get<duk_context *>(embedded_state);
+void DebugScreen::run_console_js(const std::string &source) {
+  if (js_active_profiler) {
+    js_active_profiler->set_entry("console");
+  }
+  script_deadline = GetTime() + SCRIPT_CONSOLE_TIMEOUT;
+  // +1
+  int result = script_cache.load_js(get_js_state(), source, "console");
+  if (result == DUK_EXEC_SUCCESS) {
+    // -1, +1
+    result = duk_pcall(get_js_state(), 0);
+  }
+  script_deadline = 0.0;
+
+  if (result != DUK_EXEC_SUCCESS) {
+    std::string error = duk_safe_to_string(get_js_state(), -1);
+#ifndef NDEBUG
+    std::clog << error << '\n';
+#endif
+    script_thread.call_on_render_thread(
+        [this, &error] { push_console(std::move(error)); });
   }
-  return nullptr;
+  // -1
+  duk_pop(get_js_state());
 }
+
+lua_State *DebugScreen::get_lua_state() { return lua_state; }
+
+duk_context *DebugScreen::get_js_state() { return js_state; }
@@ -5,7 +5,6 @@
 #include <bitset>
 #include <deque>
 #include <optional>
-#include <variant>
 
 // Third-party includes.
 
@@ -17,7 +16,12 @@ extern "C" {
 #include <duktape.h>
 
 // Local includes.
+#include "pool_allocator.h"
 #include "screen.h"
+#include "script_binding.h"
+#include "script_cache.h"
+#include "script_profiler.h"
+#include "script_thread.h"
 
 class DebugScreen : public Screen {
  public:
@@ -31,26 +35,64 @@ class DebugScreen : public Screen {
   virtual std::list<std::string> get_known_flags() const override;
 
  private:
+  void draw_frame_times();
+
+  void push_console(std::string line);
+  void set_console_current(std::string line);
+  void push_console_current(char c);
+  void pop_console_current();
+  static float console_glyph_width(char c);
+  void update_console_x_offset();
+  void redraw_console_texture();
+
   void cleanup_embedded_state();
+  /// Creates the Lua or Duktape state (as chosen by bit 0 of "flags") if it
+  /// wasn't yet. Scripting is only paid for once the console is used, and
+  /// each state is created once and then kept, also while not selected.
+  void ensure_embedded_state();
   void initialize_lua_state();
   void initialize_js_state();
+  /// Run on script_thread, with the deadline of SCRIPT_CONSOLE_TIMEOUT.
+  void run_console_lua(const std::string &source);
+  void run_console_js(const std::string &source);
 
   lua_State *get_lua_state();
   duk_context *get_js_state();
 
-  std::variant<lua_State *, duk_context *> embedded_state;
+  /// Must outlive the Lua state.
+  PoolAllocator lua_allocator;
+  /// Must outlive the Duktape heap.
+  PoolAllocator js_allocator;
+  /// Both are nullptr until first selected.
+  lua_State *lua_state;
+  duk_context *js_state;
+  ScriptCache script_cache;
+  ScriptProfiler lua_profiler;
+  ScriptProfiler js_profiler;
+  /// Carried by the functions bound in each state.
+  ScriptEnv lua_env;
+  ScriptEnv js_env;
+  /// Runs console lines. The states are only used from the render thread
+  /// while it isn't running one of theirs.
+  ScriptThread script_thread;
   /*
-   * 0 - If set, using lua. If unset, using javascript.
-   * 1 - If set, the embedded state has been previously initialized.
+   * 0 - If set, console input goes to lua. If unset, to javascript.
+   * 1 - If set, the line running on script_thread is Lua's, else JS's.
+   * 2 - If set, console_texture needs to be redrawn.
    */
   std::bitset<32> flags;
   SharedData *shared;
   std::deque<std::string> console;
   std::deque<std::string> history;
   std::string console_current;
-  std::optional<int> console_x_offset;
+  std::unique_ptr<RenderTexture> console_texture;
+  float console_current_width;
+  int console_x_offset;
+  /// Number of lines scrolled up from the newest.
+  unsigned int console_scroll;
   std::optional<unsigned int> history_idx;
   bool fps_enabled_cache;
+  bool frame_times_enabled_cache;
 };
 
 #endif
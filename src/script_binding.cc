@@ -0,0 +1,126 @@
+#include "script_binding.h"
+
+// Standard library includes.
+#include <format>
+
+// Third party includes.
+// lua
+extern "C" {
+#include <lauxlib.h>
+}
+
+// Local includes.
+#include "screen.h"
+
+namespace {
+constexpr const char *const duktape_hidden_symbol_env = "\xFFgander_env";
+constexpr const char *const duktape_hidden_symbol_binding =
+    "\xFFgander_binding";
+
+void push_usage(ScriptEnv &env, const char *usage) {
+  env.ss->get_shared_data().outputs.push_back(std::format("usage: {}", usage));
+}
+}  // namespace
+
+void register_lua_bindings(lua_State *l, ScriptEnv *env,
+                           std::span<const ScriptBinding> bindings) {
+  for (const auto &binding : bindings) {
+    // +1
+    lua_pushlightuserdata(l, env);
+    // +1
+    lua_pushlightuserdata(l, const_cast<ScriptBinding *>(&binding));
+    // -2, +1
+    lua_pushcclosure(l, binding.lua_func, 2);
+    // -1
+    lua_setglobal(l, binding.name);
+  }
+}
+
+void register_js_bindings(duk_context *ctx, ScriptEnv *env,
+                          std::span<const ScriptBinding> bindings) {
+  for (const auto &binding : bindings) {
+    // +1
+    duk_push_c_function(ctx, binding.js_func, binding.js_nargs);
+    // +1
+    duk_push_pointer(ctx, env);
+    // -1
+    duk_put_prop_string(ctx, -2, duktape_hidden_symbol_env);
+    // +1
+    duk_push_pointer(ctx, const_cast<ScriptBinding *>(&binding));
+    // -1
+    duk_put_prop_string(ctx, -2, duktape_hidden_symbol_binding);
+    // -1
+    duk_put_global_string(ctx, binding.name);
+  }
+}
+
+// A hidden property, as a function's 16-bit "magic" can't hold a pointer.
+ScriptEnv &js_script_env(duk_context *ctx) {
+  // +1
+  duk_push_current_function(ctx);
+  // +1
+  duk_get_prop_string(ctx, -1, duktape_hidden_symbol_env);
+  auto *env = static_cast<ScriptEnv *>(duk_get_pointer(ctx, -1));
+  // -2
+  duk_pop_2(ctx);
+  return *env;
+}
+
+int lua_script_usage(lua_State *l) {
+  const auto *binding = static_cast<const ScriptBinding *>(
+      lua_touserdata(l, lua_upvalueindex(2)));
+  push_usage(lua_script_env(l), binding->lua_usage);
+  return 0;
+}
+
+duk_ret_t js_script_usage(duk_context *ctx) {
+  // +1
+  duk_push_current_function(ctx);
+  // +1
+  duk_get_prop_string(ctx, -1, duktape_hidden_symbol_binding);
+  const auto *binding =
+      static_cast<const ScriptBinding *>(duk_get_pointer(ctx, -1));
+  // -2
+  duk_pop_2(ctx);
+  push_usage(js_script_env(ctx), binding->js_usage);
+  return 0;
+}
+
+int lua_call_on_render_thread(lua_State *l, ScriptThread *thread,
+                              lua_CFunction self) {
+  int nargs = lua_gettop(l);
+  int result = LUA_OK;
+  bool called = thread->call_on_render_thread([l, self, nargs, &result] {
+    // +1
+    lua_pushvalue(l, lua_upvalueindex(1));
+    // +1
+    lua_pushvalue(l, lua_upvalueindex(2));
+    // -2, +1
+    lua_pushcclosure(l, self, 2);
+    lua_insert(l, 1);
+    // -(nargs + 1), +results or the error.
+    result = lua_pcall(l, nargs, LUA_MULTRET, 0);
+  });
+  if (!called) {
+    return luaL_error(l, "script aborted");
+  } else if (result != LUA_OK) {
+    return lua_error(l);
+  }
+  return lua_gettop(l);
+}
+
+duk_ret_t js_call_on_render_thread(duk_context *ctx, ScriptThread *thread,
+                                   duk_safe_call_function func) {
+  duk_idx_t nargs = duk_get_top(ctx);
+  duk_int_t result = DUK_EXEC_SUCCESS;
+  bool called = thread->call_on_render_thread([ctx, func, nargs, &result] {
+    // -nargs, +1
+    result = duk_safe_call(ctx, func, nullptr, nargs, 1);
+  });
+  if (!called) {
+    return duk_error(ctx, DUK_ERR_ERROR, "script aborted");
+  } else if (result != DUK_EXEC_SUCCESS) {
+    return duk_throw(ctx);
+  }
+  return 1;
+}
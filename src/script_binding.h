@@ -0,0 +1,380 @@
+#ifndef SEODISPARATE_COM_GANDER_BATTLE_SCRIPT_BINDING_H_
+#define SEODISPARATE_COM_GANDER_BATTLE_SCRIPT_BINDING_H_
+
+// Standard library includes.
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Third party includes.
+
+// lua
+extern "C" {
+#include "lua.h"
+}
+
+#include <duktape.h>
+
+// Local includes.
+#include "script_thread.h"
+
+class PoolAllocator;
+class ScreenStack;
+class ScriptProfiler;
+
+enum class ScriptEngine { LUA, JS };
+
+/// What bound functions get besides their arguments, one per engine state.
+/// Every function registered by register_lua_bindings() or
+/// register_js_bindings() carries a pointer to it.
+struct ScriptEnv {
+  ScreenStack *ss;
+  PoolAllocator *allocator;
+  /// The other engine's, for print_vm_memory().
+  PoolAllocator *other_allocator;
+  ScriptProfiler *profiler;
+  ScriptEngine engine;
+};
+
+/// A function registered under "name" in both engines, made by
+/// script_binding() or engine_binding().
+struct ScriptBinding {
+  const char *name;
+  /// Listed by help(). Typed bindings also print it when misused.
+  const char *lua_usage;
+  const char *js_usage;
+  lua_CFunction lua_func;
+  duk_c_function js_func;
+  duk_idx_t js_nargs;
+};
+
+void register_lua_bindings(lua_State *l, ScriptEnv *env,
+                           std::span<const ScriptBinding> bindings);
+void register_js_bindings(duk_context *ctx, ScriptEnv *env,
+                          std::span<const ScriptBinding> bindings);
+
+/// The ScriptEnv of the called binding.
+inline ScriptEnv &lua_script_env(lua_State *l) {
+  return *static_cast<ScriptEnv *>(lua_touserdata(l, lua_upvalueindex(1)));
+}
+ScriptEnv &js_script_env(duk_context *ctx);
+
+/// Prints the called binding's usage. Returns 0, for the binding to return.
+int lua_script_usage(lua_State *l);
+duk_ret_t js_script_usage(duk_context *ctx);
+
+/// Calls "self" (the running binding) protected on the render thread while
+/// this one waits, then rethrows its error here. See ScriptThread.
+int lua_call_on_render_thread(lua_State *l, ScriptThread *thread,
+                              lua_CFunction self);
+/// Like lua_call_on_render_thread(), with "func" in the running binding's
+/// activation.
+duk_ret_t js_call_on_render_thread(duk_context *ctx, ScriptThread *thread,
+                                   duk_safe_call_function func);
+
+/// Converts the arguments and results of typed bindings. A failed get is
+/// the wrong type, or out of range.
+template <typename T>
+struct ScriptValue;
+
+template <>
+struct ScriptValue<bool> {
+  static bool lua_get(lua_State *l, int idx, bool &out) {
+    if (!lua_isboolean(l, idx)) {
+      return false;
+    }
+    out = lua_toboolean(l, idx) != 0;
+    return true;
+  }
+  static void lua_push(lua_State *l, bool value) {
+    lua_pushboolean(l, value ? 1 : 0);
+  }
+  static bool js_get(duk_context *ctx, duk_idx_t idx, bool &out) {
+    if (!duk_is_boolean(ctx, idx)) {
+      return false;
+    }
+    out = duk_get_boolean(ctx, idx) != 0;
+    return true;
+  }
+  static void js_push(duk_context *ctx, bool value) {
+    duk_push_boolean(ctx, value ? 1 : 0);
+  }
+};
+
+template <std::integral T>
+struct ScriptValue<T> {
+  static bool lua_get(lua_State *l, int idx, T &out) {
+    int is_integer = 0;
+    lua_Integer value = lua_tointegerx(l, idx, &is_integer);
+    if (is_integer == 0 || !std::in_range<T>(value)) {
+      return false;
+    }
+    out = static_cast<T>(value);
+    return true;
+  }
+  static void lua_push(lua_State *l, T value) {
+    lua_pushinteger(l, static_cast<lua_Integer>(value));
+  }
+  static bool js_get(duk_context *ctx, duk_idx_t idx, T &out) {
+    if (!duk_is_number(ctx, idx)) {
+      return false;
+    }
+    // Exclusive, as T's max itself may round up as a double.
+    double limit = std::ldexp(1.0, std::numeric_limits<T>::digits);
+    double value = std::trunc(duk_get_number(ctx, idx));
+    if (!(value < limit && value >= (std::is_signed_v<T> ? -limit : 0.0))) {
+      return false;
+    }
+    out = static_cast<T>(value);
+    return true;
+  }
+  static void js_push(duk_context *ctx, T value) {
+    duk_push_number(ctx, static_cast<double>(value));
+  }
+};
+
+template <std::floating_point T>
+struct ScriptValue<T> {
+  static bool lua_get(lua_State *l, int idx, T &out) {
+    int is_number = 0;
+    lua_Number value = lua_tonumberx(l, idx, &is_number);
+    out = static_cast<T>(value);
+    return is_number != 0;
+  }
+  static void lua_push(lua_State *l, T value) {
+    lua_pushnumber(l, static_cast<lua_Number>(value));
+  }
+  static bool js_get(duk_context *ctx, duk_idx_t idx, T &out) {
+    if (!duk_is_number(ctx, idx)) {
+      return false;
+    }
+    out = static_cast<T>(duk_get_number(ctx, idx));
+    return true;
+  }
+  static void js_push(duk_context *ctx, T value) {
+    duk_push_number(ctx, static_cast<double>(value));
+  }
+};
+
+/// Arguments point into the engine's string, valid during the call.
+template <>
+struct ScriptValue<std::string_view> {
+  static bool lua_get(lua_State *l, int idx, std::string_view &out) {
+    if (!lua_isstring(l, idx)) {
+      return false;
+    }
+    std::size_t size = 0;
+    const char *data = lua_tolstring(l, idx, &size);
+    out = std::string_view(data, size);
+    return true;
+  }
+  static void lua_push(lua_State *l, std::string_view value) {
+    lua_pushlstring(l, value.data(), value.size());
+  }
+  static bool js_get(duk_context *ctx, duk_idx_t idx, std::string_view &out) {
+    if (!duk_is_string(ctx, idx)) {
+      return false;
+    }
+    duk_size_t size = 0;
+    const char *data = duk_get_lstring(ctx, idx, &size);
+    out = std::string_view(data, size);
+    return true;
+  }
+  static void js_push(duk_context *ctx, std::string_view value) {
+    duk_push_lstring(ctx, value.data(), value.size());
+  }
+};
+
+/// Results only.
+template <>
+struct ScriptValue<std::string> {
+  static void lua_push(lua_State *l, const std::string &value) {
+    ScriptValue<std::string_view>::lua_push(l, value);
+  }
+  static void js_push(duk_context *ctx, const std::string &value) {
+    ScriptValue<std::string_view>::js_push(ctx, value);
+  }
+};
+
+/// An optional argument may be left out, or nil (null or undefined in JS).
+/// An empty result is nil (undefined in JS).
+template <typename T>
+struct ScriptValue<std::optional<T> > {
+  static bool lua_get(lua_State *l, int idx, std::optional<T> &out) {
+    if (lua_isnoneornil(l, idx)) {
+      out.reset();
+      return true;
+    }
+    T value{};
+    if (!ScriptValue<T>::lua_get(l, idx, value)) {
+      return false;
+    }
+    out = value;
+    return true;
+  }
+  static void lua_push(lua_State *l, const std::optional<T> &value) {
+    if (value.has_value()) {
+      ScriptValue<T>::lua_push(l, value.value());
+    } else {
+      lua_pushnil(l);
+    }
+  }
+  static bool js_get(duk_context *ctx, duk_idx_t idx, std::optional<T> &out) {
+    if (duk_is_null_or_undefined(ctx, idx)) {
+      out.reset();
+      return true;
+    }
+    T value{};
+    if (!ScriptValue<T>::js_get(ctx, idx, value)) {
+      return false;
+    }
+    out = value;
+    return true;
+  }
+  static void js_push(duk_context *ctx, const std::optional<T> &value) {
+    if (value.has_value()) {
+      ScriptValue<T>::js_push(ctx, value.value());
+    } else {
+      duk_push_undefined(ctx);
+    }
+  }
+};
+
+/// Typed bindings are functions like "bool f(ScriptEnv &, std::string_view)".
+template <typename Fn>
+struct ScriptSignature;
+
+template <typename R, typename... Args>
+struct ScriptSignature<R (*)(ScriptEnv &, Args...)> {
+  using Result = R;
+  using Arguments = std::tuple<std::remove_cvref_t<Args>...>;
+  static constexpr std::size_t ARITY = sizeof...(Args);
+};
+
+template <typename Tuple, std::size_t... Idx>
+bool lua_get_arguments(lua_State *l, Tuple &args,
+                       std::index_sequence<Idx...>) {
+  return (ScriptValue<std::tuple_element_t<Idx, Tuple> >::lua_get(
+              l, (int)Idx + 1, std::get<Idx>(args)) &&
+          ...);
+}
+
+template <typename Tuple, std::size_t... Idx>
+bool js_get_arguments(duk_context *ctx, Tuple &args,
+                      std::index_sequence<Idx...>) {
+  return (ScriptValue<std::tuple_element_t<Idx, Tuple> >::js_get(
+              ctx, (duk_idx_t)Idx, std::get<Idx>(args)) &&
+          ...);
+}
+
+/// Converts the arguments to Fn's parameters, calls it, and pushes its
+/// result. Prints the usage instead if they don't convert.
+template <auto Fn>
+int lua_typed_binding(lua_State *l) {
+  using Signature = ScriptSignature<decltype(Fn)>;
+  using Result = typename Signature::Result;
+
+  typename Signature::Arguments args;
+  if (lua_gettop(l) > (int)Signature::ARITY ||
+      !lua_get_arguments(l, args,
+                         std::make_index_sequence<Signature::ARITY>())) {
+    return lua_script_usage(l);
+  }
+
+  auto call = [l](auto &...values) { return Fn(lua_script_env(l), values...); };
+  if constexpr (std::is_void_v<Result>) {
+    std::apply(call, args);
+    return 0;
+  } else {
+    // +1
+    ScriptValue<std::remove_cvref_t<Result> >::lua_push(l,
+                                                        std::apply(call, args));
+    return 1;
+  }
+}
+
+/// Like lua_typed_binding(). Registered with Fn's arity, so Duktape drops
+/// extra arguments and fills missing ones with undefined.
+template <auto Fn>
+duk_ret_t js_typed_binding(duk_context *ctx) {
+  using Signature = ScriptSignature<decltype(Fn)>;
+  using Result = typename Signature::Result;
+
+  typename Signature::Arguments args;
+  if (!js_get_arguments(ctx, args,
+                        std::make_index_sequence<Signature::ARITY>())) {
+    return js_script_usage(ctx);
+  }
+
+  auto call = [ctx](auto &...values) {
+    return Fn(js_script_env(ctx), values...);
+  };
+  if constexpr (std::is_void_v<Result>) {
+    std::apply(call, args);
+    return 0;
+  } else {
+    // +1
+    ScriptValue<std::remove_cvref_t<Result> >::js_push(ctx,
+                                                       std::apply(call, args));
+    return 1;
+  }
+}
+
+/// Bindings use SharedData and the ScreenStack, so they run on the render
+/// thread. Called from the script thread, Func is handed to it.
+template <lua_CFunction Func>
+int lua_render_thread_binding(lua_State *l) {
+  if (ScriptThread *thread = ScriptThread::current()) {
+    return lua_call_on_render_thread(l, thread,
+                                     &lua_render_thread_binding<Func>);
+  }
+  return Func(l);
+}
+
+template <duk_c_function Func>
+duk_ret_t js_render_thread_binding(duk_context *ctx) {
+  if (ScriptThread *thread = ScriptThread::current()) {
+    return js_call_on_render_thread(
+        ctx, thread,
+        [](duk_context *ctx, void *) -> duk_ret_t { return Func(ctx); });
+  }
+  return Func(ctx);
+}
+
+/// Binds Fn, a typed binding, in both engines.
+template <auto Fn>
+constexpr ScriptBinding script_binding(const char *name,
+                                       const char *lua_usage,
+                                       const char *js_usage = nullptr) {
+  return ScriptBinding{
+      name,
+      lua_usage,
+      js_usage ? js_usage : lua_usage,
+      &lua_render_thread_binding<&lua_typed_binding<Fn> >,
+      &js_render_thread_binding<&js_typed_binding<Fn> >,
+      (duk_idx_t)ScriptSignature<decltype(Fn)>::ARITY};
+}
+
+/// Binds a function written against each engine's API, for values the typed
+/// bindings don't convert (tables, functions, variable arguments).
+template <lua_CFunction LuaFunc, duk_c_function JsFunc>
+constexpr ScriptBinding engine_binding(const char *name, duk_idx_t js_nargs,
+                                       const char *lua_usage,
+                                       const char *js_usage = nullptr) {
+  return ScriptBinding{name,
+                       lua_usage,
+                       js_usage ? js_usage : lua_usage,
+                       &lua_render_thread_binding<LuaFunc>,
+                       &js_render_thread_binding<JsFunc>,
+                       js_nargs};
+}
+
+#endif
@@ -0,0 +1,179 @@
+#include "script_cache.h"
+
+// Standard library includes.
+#include <cstring>
+#include <span>
+#include <string>
+
+// Third party includes.
+// lua
+extern "C" {
+#include <lauxlib.h>
+}
+
+// Local includes.
+#include "resource_archive.h"
+#include "resource_handler.h"
+
+namespace {
+constexpr const char *const lua_chunk_cache_key = "chunk_cache";
+}  // namespace
+
+ScriptCache::ScriptCache() : js_bytecode(), lua_entries(0) {}
+
+int ScriptCache::load_lua(lua_State *l, std::string_view source,
+                          const char *chunk_name) {
+  lua_Integer key = (lua_Integer)hash_source(source);
+
+  // +1
+  if (lua_getfield(l, LUA_REGISTRYINDEX, lua_chunk_cache_key) != LUA_TTABLE) {
+    // A new state, so nothing of it is cached yet.
+    // -1
+    lua_pop(l, 1);
+    // +1
+    lua_createtable(l, 0, 0);
+    // +1
+    lua_pushvalue(l, -1);
+    // -1
+    lua_setfield(l, LUA_REGISTRYINDEX, lua_chunk_cache_key);
+    lua_entries = 0;
+  }
+
+  // +1
+  if (lua_rawgeti(l, -1, key) == LUA_TFUNCTION) {
+    // -1
+    lua_remove(l, -2);
+    return LUA_OK;
+  }
+  // -1
+  lua_pop(l, 1);
+
+  // +1
+  int result = luaL_loadbufferx(l, source.data(), source.size(), chunk_name,
+                                "t");
+  if (result == LUA_OK) {
+    if (lua_entries >= SCRIPT_CACHE_MAX_ENTRIES) {
+      // +1
+      lua_createtable(l, 0, 0);
+      // +1
+      lua_pushvalue(l, -1);
+      // -1
+      lua_setfield(l, LUA_REGISTRYINDEX, lua_chunk_cache_key);
+      // -1
+      lua_replace(l, -3);
+      lua_entries = 0;
+    }
+    // +1
+    lua_pushvalue(l, -1);
+    // -1
+    lua_rawseti(l, -3, key);
+    ++lua_entries;
+  }
+  // -1
+  lua_remove(l, -2);
+  return result;
+}
+
+duk_int_t ScriptCache::load_js(duk_context *ctx, std::string_view source,
+                               const char *file_name) {
+  std::uint64_t key = hash_source(source);
+
+  if (auto iter = js_bytecode.find(key); iter != js_bytecode.end()) {
+    // +1
+    void *buffer = duk_push_fixed_buffer(ctx, iter->second.size());
+    std::memcpy(buffer, iter->second.data(), iter->second.size());
+    // -1, +1
+    duk_load_function(ctx);
+    return DUK_EXEC_SUCCESS;
+  }
+
+  // +1
+  duk_push_string(ctx, file_name);
+  // -1, +1
+  duk_int_t result =
+      duk_pcompile_lstring_filename(ctx, 0, source.data(), source.size());
+  if (result != DUK_EXEC_SUCCESS) {
+    return result;
+  }
+
+  // +1
+  duk_dup_top(ctx);
+  // -1, +1
+  duk_dump_function(ctx);
+  duk_size_t size = 0;
+  const auto *bytecode =
+      static_cast<const std::byte *>(duk_get_buffer(ctx, -1, &size));
+  if (js_bytecode.size() >= SCRIPT_CACHE_MAX_ENTRIES) {
+    js_bytecode.clear();
+  }
+  js_bytecode.emplace(key, std::vector<std::byte>(bytecode, bytecode + size));
+  // -1
+  duk_pop(ctx);
+
+  return DUK_EXEC_SUCCESS;
+}
+
+int ScriptCache::load_lua_file(lua_State *l, const char *filename) {
+  auto view = ResourceHandler::load_view(filename);
+  if (view.empty()) {
+    // +1
+    lua_pushfstring(l, "cannot load %s", filename);
+    return LUA_ERRFILE;
+  }
+
+  // Chunk names match what the packer compiled with.
+  std::string chunk_name = std::string("@") + filename;
+  bool precompiled = view.file_type() == SCRIPT_LUA_BYTECODE_TYPE;
+  // +1
+  return luaL_loadbufferx(
+      l, reinterpret_cast<const char *>(view.data().data()),
+      view.data().size(), chunk_name.c_str(), precompiled ? "b" : "t");
+}
+
+duk_int_t ScriptCache::load_js_file(duk_context *ctx, const char *filename) {
+  auto view = ResourceHandler::load_view(filename);
+  if (view.empty()) {
+    // +1
+    duk_push_sprintf(ctx, "cannot load %s", filename);
+    return DUK_EXEC_ERROR;
+  }
+
+  auto source = view.data();
+  if (view.file_type() == SCRIPT_JS_BYTECODE_TYPE) {
+    std::uint32_t source_size = 0;
+    if (source.size() >= sizeof(source_size)) {
+      std::memcpy(&source_size, source.data(), sizeof(source_size));
+    }
+    if (source.size() < sizeof(source_size) ||
+        source.size() - sizeof(source_size) < source_size) {
+      // +1
+      duk_push_sprintf(ctx, "cannot load %s, truncated bytecode", filename);
+      return DUK_EXEC_ERROR;
+    }
+    auto bytecode = source.subspan(sizeof(source_size) + source_size);
+    source = source.subspan(sizeof(source_size), source_size);
+
+    auto marker = std::as_bytes(std::span(SCRIPT_JS_BYTECODE_MARKER));
+    if (bytecode.size() > marker.size() &&
+        std::memcmp(bytecode.data(), marker.data(), marker.size()) == 0) {
+      bytecode = bytecode.subspan(marker.size());
+      // +1
+      void *buffer = duk_push_fixed_buffer(ctx, bytecode.size());
+      std::memcpy(buffer, bytecode.data(), bytecode.size());
+      // -1, +1
+      duk_load_function(ctx);
+      return DUK_EXEC_SUCCESS;
+    }
+    // Dumped by another Duktape build, so compile the source it kept.
+  }
+
+  // +1
+  duk_push_string(ctx, filename);
+  // -1, +1
+  return duk_pcompile_lstring_filename(
+      ctx, 0, reinterpret_cast<const char *>(source.data()), source.size());
+}
+
+std::uint64_t ScriptCache::hash_source(std::string_view source) {
+  return ResourceArchive::hash_bytes(std::as_bytes(std::span(source)), 0);
+}
@@ -0,0 +1,66 @@
+#ifndef SEODISPARATE_COM_GANDER_BATTLE_SCRIPT_CACHE_H_
+#define SEODISPARATE_COM_GANDER_BATTLE_SCRIPT_CACHE_H_
+
+// Standard library includes.
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Third party includes.
+
+// lua
+extern "C" {
+#include "lua.h"
+}
+
+#include <duktape.h>
+
+/// File types the packer gives scripts it precompiled, see View::file_type().
+constexpr const char *const SCRIPT_LUA_BYTECODE_TYPE = ".luac";
+constexpr const char *const SCRIPT_JS_BYTECODE_TYPE = ".dukbc";
+
+/*
+ * A precompiled JS script. Duktape bytecode only loads into the Duktape
+ * build that dumped it, so the source is kept to compile instead when the
+ * marker doesn't match. Layout, integers in native byte order:
+ *   u32 source size, source, SCRIPT_JS_BYTECODE_MARKER, bytecode
+ */
+constexpr std::string_view SCRIPT_JS_BYTECODE_MARKER =
+    "GBJS " DUK_GIT_DESCRIBE "\n";
+
+/// Past this many entries a cache is emptied before adding another.
+constexpr std::size_t SCRIPT_CACHE_MAX_ENTRIES = 256;
+
+/// Compiled console lines, keyed by a hash of their source, so running the
+/// same source again skips the parser. Compiled Lua functions are kept in
+/// the Lua state's registry. Duktape's are kept here as bytecode (see
+/// duk_dump_function()), so they outlive the heap.
+class ScriptCache {
+ public:
+  ScriptCache();
+
+  /// Pushes the compiled "source", or the error message if it doesn't
+  /// compile. Returns the luaL_loadbufferx() result.
+  int load_lua(lua_State *l, std::string_view source, const char *chunk_name);
+  /// Pushes the compiled "source" as global code to call with no arguments,
+  /// or the error if it doesn't compile. Returns 0 on success.
+  duk_int_t load_js(duk_context *ctx, std::string_view source,
+                    const char *file_name);
+
+  /// Pushes the script resource "filename" compiled, loading the packer's
+  /// bytecode if it precompiled it. Returns LUA_ERRFILE if it is missing.
+  static int load_lua_file(lua_State *l, const char *filename);
+  /// Like load_lua_file(). Returns DUK_EXEC_ERROR if it is missing.
+  static duk_int_t load_js_file(duk_context *ctx, const char *filename);
+
+ private:
+  static std::uint64_t hash_source(std::string_view source);
+
+  std::unordered_map<std::uint64_t, std::vector<std::byte> > js_bytecode;
+  /// Entries in the current Lua state's registry cache.
+  std::size_t lua_entries;
+};
+
+#endif
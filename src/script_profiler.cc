@@ -0,0 +1,95 @@
+#include "script_profiler.h"
+
+// Standard library includes.
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <utility>
+
+ScriptProfiler::ScriptProfiler()
+    : samples(),
+      scratch(),
+      entry(),
+      total(0),
+      start_time(),
+      duration(),
+      running(false) {}
+
+void ScriptProfiler::start() {
+  samples.clear();
+  total = 0;
+  start_time = std::chrono::steady_clock::now();
+  duration = {};
+  running = true;
+}
+
+void ScriptProfiler::stop() {
+  if (running) {
+    duration = std::chrono::steady_clock::now() - start_time;
+    running = false;
+  }
+}
+
+bool ScriptProfiler::is_running() const { return running; }
+
+void ScriptProfiler::add_sample(std::string_view source, int line,
+                                std::string_view function) {
+  char line_chars[16];
+  auto line_end =
+      std::to_chars(line_chars, line_chars + sizeof(line_chars), line).ptr;
+
+  scratch.clear();
+  scratch.append(source);
+  scratch.push_back(':');
+  scratch.append(line_chars, line_end);
+  scratch.push_back(' ');
+  scratch.append(function);
+  add_sample(scratch);
+}
+
+void ScriptProfiler::add_entry_sample() { add_sample(entry); }
+
+void ScriptProfiler::set_entry(std::string_view label) { entry = label; }
+
+void ScriptProfiler::set_entry(std::string_view label, std::size_t index) {
+  char index_chars[24];
+  auto index_end =
+      std::to_chars(index_chars, index_chars + sizeof(index_chars), index).ptr;
+
+  entry = label;
+  entry.push_back(' ');
+  entry.append(index_chars, index_end);
+}
+
+std::vector<std::string> ScriptProfiler::report(std::size_t count) const {
+  std::vector<std::pair<std::string_view, std::size_t> > sorted(
+      samples.begin(), samples.end());
+  count = std::min(count, sorted.size());
+  std::partial_sort(
+      sorted.begin(), sorted.begin() + (std::ptrdiff_t)count, sorted.end(),
+      [](const auto &a, const auto &b) { return a.second > b.second; });
+
+  auto elapsed = running ? std::chrono::steady_clock::now() - start_time
+                         : duration;
+  std::vector<std::string> lines;
+  lines.push_back(std::format(
+      "  {} samples over {:.1f} s{}:", total,
+      std::chrono::duration<double>(elapsed).count(),
+      running ? " (running)" : ""));
+  for (std::size_t idx = 0; idx < count; ++idx) {
+    lines.push_back(std::format(
+        "{:5.1f}% {:6} {}",
+        100.0 * (double)sorted[idx].second / (double)total, sorted[idx].second,
+        sorted[idx].first));
+  }
+  return lines;
+}
+
+void ScriptProfiler::add_sample(std::string_view label) {
+  ++total;
+  if (auto iter = samples.find(label); iter != samples.end()) {
+    ++iter->second;
+  } else {
+    samples.emplace(label, 1);
+  }
+}
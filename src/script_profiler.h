@@ -0,0 +1,61 @@
+#ifndef SEODISPARATE_COM_GANDER_BATTLE_SCRIPT_PROFILER_H_
+#define SEODISPARATE_COM_GANDER_BATTLE_SCRIPT_PROFILER_H_
+
+// Standard library includes.
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// Counts samples of where a script was running, by label (like
+/// "source:line function"). Samples are taken every so many instructions, so
+/// a label's share of the samples is its share of the script's run time.
+class ScriptProfiler {
+ public:
+  ScriptProfiler();
+
+  /// Clears previous samples.
+  void start();
+  void stop();
+  bool is_running() const;
+
+  /// Doesn't allocate once the label was seen.
+  void add_sample(std::string_view source, int line,
+                  std::string_view function);
+  /// For engines that can only tell which entry point is running.
+  void add_entry_sample();
+  /// Sets the label of add_entry_sample(). Reuses the label's storage, so
+  /// switching between entry points doesn't allocate either.
+  void set_entry(std::string_view label);
+  /// As set_entry(), labelled "label index".
+  void set_entry(std::string_view label, std::size_t index);
+
+  /// The "count" labels with the most samples, hottest first, as console
+  /// lines.
+  std::vector<std::string> report(std::size_t count) const;
+
+ private:
+  struct LabelHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view label) const {
+      return std::hash<std::string_view>{}(label);
+    }
+  };
+
+  void add_sample(std::string_view label);
+
+  std::unordered_map<std::string, std::size_t, LabelHash, std::equal_to<> >
+      samples;
+  /// Reused to build labels without allocating.
+  std::string scratch;
+  std::string entry;
+  std::size_t total;
+  std::chrono::steady_clock::time_point start_time;
+  std::chrono::steady_clock::duration duration;
+  bool running;
+};
+
+#endif
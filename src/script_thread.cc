@@ -0,0 +1,136 @@
+#include "script_thread.h"
+
+// Standard library includes.
+#include <chrono>
+#include <utility>
+
+namespace {
+thread_local ScriptThread *current_script_thread = nullptr;
+}  // namespace
+
+ScriptThread::ScriptThread()
+    : mutex(),
+      condition(),
+      task(),
+      render_call(nullptr),
+      busy(false),
+      stopping(false),
+      finishing(false),
+      thread() {}
+
+ScriptThread::~ScriptThread() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  condition.notify_all();
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+bool ScriptThread::start(Task task) {
+  std::unique_lock<std::mutex> lock(mutex);
+  if (busy) {
+    return false;
+  }
+  busy = true;
+
+#ifdef __EMSCRIPTEN__
+  lock.unlock();
+  task();
+  lock.lock();
+  busy = false;
+#else
+  this->task = std::move(task);
+  if (!thread.joinable()) {
+    // It waits on "mutex" until this returns, then finds the task.
+    thread = std::thread(&ScriptThread::worker, this);
+  }
+  condition.notify_all();
+#endif
+  return true;
+}
+
+bool ScriptThread::is_busy() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return busy;
+}
+
+bool ScriptThread::call_on_render_thread(const Task &call) {
+  if (current_script_thread != this) {
+    call();
+    return true;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  if (finishing || stopping) {
+    return false;
+  }
+  render_call = &call;
+  condition.notify_all();
+  condition.wait(lock, [this] {
+    return render_call == nullptr || finishing || stopping;
+  });
+
+  // service() clears it once the call is made.
+  bool called = render_call == nullptr;
+  render_call = nullptr;
+  return called;
+}
+
+void ScriptThread::service(double budget) {
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::duration<double>(budget));
+
+  std::unique_lock<std::mutex> lock(mutex);
+  // A task that isn't calling doesn't hold up the frame.
+  while (busy && render_call) {
+    const Task *call = render_call;
+    lock.unlock();
+    (*call)();
+    lock.lock();
+    render_call = nullptr;
+    condition.notify_all();
+
+    // Scripts often call again right away, so wait a little for the next.
+    condition.wait_until(lock, deadline,
+                         [this] { return render_call || !busy; });
+    if (std::chrono::steady_clock::now() >= deadline) {
+      break;
+    }
+  }
+}
+
+void ScriptThread::finish() {
+  std::unique_lock<std::mutex> lock(mutex);
+  finishing = true;
+  condition.notify_all();
+  condition.wait(lock, [this] { return !busy; });
+  finishing = false;
+}
+
+bool ScriptThread::is_finishing() const { return finishing; }
+
+ScriptThread *ScriptThread::current() { return current_script_thread; }
+
+void ScriptThread::worker() {
+  current_script_thread = this;
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    condition.wait(lock, [this] { return stopping || task; });
+    if (stopping) {
+      return;
+    }
+
+    Task running = std::move(task);
+    task = nullptr;
+    lock.unlock();
+    running();
+    lock.lock();
+    busy = false;
+    condition.notify_all();
+  }
+}
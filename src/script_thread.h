@@ -0,0 +1,71 @@
+#ifndef SEODISPARATE_COM_GANDER_BATTLE_SCRIPT_THREAD_H_
+#define SEODISPARATE_COM_GANDER_BATTLE_SCRIPT_THREAD_H_
+
+// Standard library includes.
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/// Runs one task at a time, like a console line, on a thread of its own, so a
+/// long running script doesn't stall the frame. The task hands anything that
+/// must happen on the render thread (SharedData, the ScreenStack) to
+/// call_on_render_thread(), which the render thread runs from service().
+///
+/// The thread is started by the first start(), so a console that is never
+/// used costs no thread. Emscripten builds have no threads and run the task
+/// inside start() instead.
+class ScriptThread {
+ public:
+  using Task = std::function<void()>;
+
+  ScriptThread();
+  ~ScriptThread();
+
+  // No copy.
+  ScriptThread(const ScriptThread &) = delete;
+  ScriptThread &operator=(const ScriptThread &) = delete;
+
+  // No move, the thread refers to this.
+  ScriptThread(ScriptThread &&) = delete;
+  ScriptThread &operator=(ScriptThread &&) = delete;
+
+  /// Returns false if the previous task is still running.
+  bool start(Task task);
+  bool is_busy();
+
+  /// From the task, runs "call" on the render thread during its next
+  /// service() and waits for it. Returns false without running it if the
+  /// render thread is in finish(). Called from any other thread, runs "call"
+  /// directly.
+  bool call_on_render_thread(const Task &call);
+
+  /// Runs calls from the task. Once one arrives, waits for more until
+  /// "budget" seconds pass or the task ends. Call once per frame.
+  void service(double budget);
+
+  /// Waits for the task to end, failing its calls to the render thread
+  /// meanwhile. The task should check is_finishing() to end early.
+  void finish();
+  bool is_finishing() const;
+
+  /// The ScriptThread whose task is calling, nullptr on any other thread.
+  static ScriptThread *current();
+
+ private:
+  void worker();
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  /// Waiting for the thread to start it.
+  Task task;
+  /// Waiting for service().
+  const Task *render_call;
+  bool busy;
+  bool stopping;
+  std::atomic<bool> finishing;
+  std::thread thread;
+};
+
+#endif
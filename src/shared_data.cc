@@ -1,6 +1,30 @@
 #include "shared_data.h"
 
-SharedData::SharedData() : outputs(), flags() {}
+// Standard library includes.
+#include <random>
+
+namespace {
+std::uint64_t random_seed() {
+  std::random_device device;
+  std::uint64_t high = device();
+  return (high << 32U) | device();
+}
+}  // namespace
+
+SharedData::SharedData()
+    : outputs(),
+      flags(),
+      combatants(),
+      frame_times(),
+      rng(0),
+      rng_seed(random_seed()) {
+  seed_rng(rng_seed);
+}
+
+void SharedData::seed_rng(std::uint64_t seed) {
+  rng = Rng(seed);
+  rng_seed = seed;
+}
 
 void SharedData::init_flag(std::string name, bool value) {
   if (auto iter = flags.find(name); iter == flags.end()) {
@@ -29,7 +53,7 @@ std::optional<bool> SharedData::unset_flag(std::string name) {
   }
 }
 
-std::optional<bool> SharedData::get_flag(std::string name) {
+std::optional<bool> SharedData::get_flag(std::string_view name) {
   if (auto iter = flags.find(name); iter != flags.end()) {
     return iter->second;
   } else {
@@ -47,7 +71,8 @@ bool SharedData::toggle_flag(std::string name) {
   }
 }
 
-std::optional<bool> SharedData::set_flag_lua(std::string name, bool value) {
+std::optional<bool> SharedData::set_flag_lua(std::string_view name,
+                                             bool value) {
   if (auto iter = flags.find(name); iter != flags.end()) {
     bool prev = iter->second;
     iter->second = value;
@@ -57,7 +82,7 @@ std::optional<bool> SharedData::set_flag_lua(std::string name, bool value) {
   }
 }
 
-std::optional<bool> SharedData::toggle_flag_lua(std::string name) {
+std::optional<bool> SharedData::toggle_flag_lua(std::string_view name) {
   if (auto iter = flags.find(name); iter != flags.end()) {
     iter->second = !iter->second;
     return iter->second;
@@ -1,15 +1,31 @@
 #ifndef SEODISPARATE_COM_GANDER_BATTLE_SHARED_DATA_H_
 #define SEODISPARATE_COM_GANDER_BATTLE_SHARED_DATA_H_
 
+#include <cstdint>
+#include <functional>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
+// Local includes.
+#include "frame_times.h"
+#include "rng.h"
+
 class SharedData {
  public:
+  /// Position and velocity of one battling sphere.
+  struct Combatant {
+    float x, y, z;
+    float vx, vy, vz;
+  };
+
   SharedData();
 
+  /// Restarts "rng" from "seed", to repeat an earlier run.
+  void seed_rng(std::uint64_t seed);
+
   /// Initializes flag if it does not exist.
   void init_flag(std::string name, bool value = false);
   /// Returns prev value.
@@ -17,18 +33,33 @@ class SharedData {
   /// Returns prev value.
   std::optional<bool> unset_flag(std::string name);
   /// Returns value.
-  std::optional<bool> get_flag(std::string name);
+  std::optional<bool> get_flag(std::string_view name);
 
   /// Returns value.
   bool toggle_flag(std::string name);
 
   /// Returns prev value.
-  std::optional<bool> set_flag_lua(std::string name, bool value);
+  std::optional<bool> set_flag_lua(std::string_view name, bool value);
   /// Returns value.
-  std::optional<bool> toggle_flag_lua(std::string name);
+  std::optional<bool> toggle_flag_lua(std::string_view name);
+
+  /// Lets "flags" be looked up by std::string_view without a copy.
+  struct FlagHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view name) const {
+      return std::hash<std::string_view>{}(name);
+    }
+  };
 
   std::vector<std::string> outputs;
-  std::unordered_map<std::string, bool> flags;
+  std::unordered_map<std::string, bool, FlagHash, std::equal_to<> > flags;
+  /// Written by BattleScreen every update, read by the per-tick script hooks.
+  std::vector<Combatant> combatants;
+  FrameTimes frame_times;
+  /// Seeded from std::random_device unless seed_rng() is called. Screens split
+  /// their own streams off of it when constructed.
+  Rng rng;
+  std::uint64_t rng_seed;
 };
 
 #endif
@@ -0,0 +1,212 @@
+// Standard library includes.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Local includes.
+#include "battle_sim.h"
+#include "rng.h"
+
+constexpr unsigned int SIM_DEFAULT_BATTLES = 1000;
+constexpr unsigned int SIM_DEFAULT_TICKS = 3600;
+constexpr float SIM_DEFAULT_DT = 1.0F / 60.0F;
+
+namespace {
+/// What one auto movement battle did over all of its ticks.
+struct BattleResult {
+  /// Ticks on which the spheres bounced off each other.
+  unsigned int collisions;
+  unsigned int floor_contacts;
+  unsigned int separations;
+  float separation_time_total;
+  float separation_time_max;
+  /// Negative if the spheres never collided.
+  float first_collision_time;
+};
+
+BattleResult run_battle(const BattleSimParams &params, Rng rng,
+                        unsigned int ticks, float dt) {
+  std::array<float, AUTOMOVE_RANDOM_COUNT> random;
+  rng.fill(random);
+
+  BattleSim sim(params);
+  sim.start_auto_move(random);
+
+  BattleResult result{0, 0, 0, 0.0F, 0.0F, -1.0F};
+  for (unsigned int tick = 0; tick < ticks; ++tick) {
+    auto events = sim.step(dt, true);
+    if (events.collided) {
+      if (result.collisions == 0) {
+        result.first_collision_time = (float)tick * dt;
+      }
+      ++result.collisions;
+    }
+    if (events.separated) {
+      ++result.separations;
+      result.separation_time_total += events.separation_time;
+      result.separation_time_max =
+          std::max(result.separation_time_max, events.separation_time);
+    }
+    result.floor_contacts += events.floor_contact[0] ? 1 : 0;
+    result.floor_contacts += events.floor_contact[1] ? 1 : 0;
+  }
+  return result;
+}
+
+void print_usage() {
+  std::cout << "Usage: GanderBattleSim [--battles <n>] [--ticks <n>] "
+               "[--dt <seconds>] [--seed <n>] [--threads <n>] "
+               "[--speed <units/s>] [--gravity <units/s^2>] "
+               "[--drop-height <units>] [--space <half width>] "
+               "[--radius <units>] [--per-battle] [--help]\n";
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  unsigned int battles = SIM_DEFAULT_BATTLES;
+  unsigned int ticks = SIM_DEFAULT_TICKS;
+  float dt = SIM_DEFAULT_DT;
+  std::uint64_t seed = 0;
+  unsigned int thread_count = std::thread::hardware_concurrency();
+  bool per_battle = false;
+  BattleSimParams params;
+  for (int idx = 1; idx < argc; ++idx) {
+    if (std::strcmp(argv[idx], "--battles") == 0 && idx + 1 < argc) {
+      battles = (unsigned int)std::strtoul(argv[++idx], nullptr, 10);
+    } else if (std::strcmp(argv[idx], "--ticks") == 0 && idx + 1 < argc) {
+      ticks = (unsigned int)std::strtoul(argv[++idx], nullptr, 10);
+    } else if (std::strcmp(argv[idx], "--dt") == 0 && idx + 1 < argc) {
+      dt = std::strtof(argv[++idx], nullptr);
+    } else if (std::strcmp(argv[idx], "--seed") == 0 && idx + 1 < argc) {
+      const char *arg = argv[++idx];
+      const char *end = arg + std::strlen(arg);
+      if (auto [ptr, ec] = std::from_chars(arg, end, seed);
+          ec != std::errc() || ptr != end) {
+        print_usage();
+        return 1;
+      }
+    } else if (std::strcmp(argv[idx], "--threads") == 0 && idx + 1 < argc) {
+      thread_count = (unsigned int)std::strtoul(argv[++idx], nullptr, 10);
+    } else if (std::strcmp(argv[idx], "--speed") == 0 && idx + 1 < argc) {
+      params.automove_speed = std::strtof(argv[++idx], nullptr);
+    } else if (std::strcmp(argv[idx], "--gravity") == 0 && idx + 1 < argc) {
+      params.drop_acc = std::strtof(argv[++idx], nullptr);
+    } else if (std::strcmp(argv[idx], "--drop-height") == 0 &&
+               idx + 1 < argc) {
+      params.drop_height = std::strtof(argv[++idx], nullptr);
+    } else if (std::strcmp(argv[idx], "--space") == 0 && idx + 1 < argc) {
+      params.space_width = std::strtof(argv[++idx], nullptr);
+      params.space_depth = params.space_width;
+    } else if (std::strcmp(argv[idx], "--radius") == 0 && idx + 1 < argc) {
+      params.radius = std::strtof(argv[++idx], nullptr);
+    } else if (std::strcmp(argv[idx], "--per-battle") == 0) {
+      per_battle = true;
+    } else if (std::strcmp(argv[idx], "--help") == 0 ||
+               std::strcmp(argv[idx], "-h") == 0) {
+      print_usage();
+      return 0;
+    } else {
+      print_usage();
+      return 1;
+    }
+  }
+  if (battles == 0 || dt <= 0.0F) {
+    print_usage();
+    return 1;
+  }
+  thread_count = std::clamp(thread_count, 1U, battles);
+
+  // Battle "idx" always uses stream "idx" of "seed", so the results don't
+  // depend on which thread ran it.
+  std::vector<BattleResult> results(battles);
+  std::atomic<unsigned int> next_battle(0);
+  auto start_time = std::chrono::steady_clock::now();
+  {
+    std::vector<std::thread> threads;
+    for (unsigned int idx = 0; idx < thread_count; ++idx) {
+      threads.emplace_back([&] {
+        for (unsigned int battle = next_battle++; battle < battles;
+             battle = next_battle++) {
+          results[battle] = run_battle(params, Rng(seed, battle), ticks, dt);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start_time)
+                       .count();
+
+  if (per_battle) {
+    std::cout << "battle,collisions,floor_contacts,separations,"
+                 "separation_time_mean,separation_time_max,"
+                 "first_collision_time\n";
+    for (unsigned int idx = 0; idx < battles; ++idx) {
+      const auto &result = results[idx];
+      std::cout << std::format(
+          "{},{},{},{},{:.4f},{:.4f},{:.4f}\n", idx, result.collisions,
+          result.floor_contacts, result.separations,
+          result.separations == 0 ? 0.0F
+                                  : result.separation_time_total /
+                                        (float)result.separations,
+          result.separation_time_max, result.first_collision_time);
+    }
+    return 0;
+  }
+
+  unsigned long long collisions = 0;
+  unsigned int collisions_min = results[0].collisions;
+  unsigned int collisions_max = 0;
+  unsigned int no_collision_battles = 0;
+  unsigned long long floor_contacts = 0;
+  unsigned long long separations = 0;
+  double separation_time_total = 0.0;
+  float separation_time_max = 0.0F;
+  double first_collision_time_total = 0.0;
+  for (const auto &result : results) {
+    collisions += result.collisions;
+    collisions_min = std::min(collisions_min, result.collisions);
+    collisions_max = std::max(collisions_max, result.collisions);
+    floor_contacts += result.floor_contacts;
+    separations += result.separations;
+    separation_time_total += result.separation_time_total;
+    separation_time_max =
+        std::max(separation_time_max, result.separation_time_max);
+    if (result.collisions == 0) {
+      ++no_collision_battles;
+    } else {
+      first_collision_time_total += result.first_collision_time;
+    }
+  }
+  unsigned int collided_battles = battles - no_collision_battles;
+
+  std::cout << "battles,ticks,dt,seed,threads,collisions_mean,collisions_min,"
+               "collisions_max,no_collision_battles,floor_contacts_mean,"
+               "separations,separation_time_mean,separation_time_max,"
+               "first_collision_time_mean,elapsed_s\n";
+  std::cout << std::format(
+      "{},{},{:.6f},{},{},{:.3f},{},{},{},{:.3f},{},{:.4f},{:.4f},{:.4f},"
+      "{:.3f}\n",
+      battles, ticks, dt, seed, thread_count,
+      (double)collisions / (double)battles, collisions_min, collisions_max,
+      no_collision_battles, (double)floor_contacts / (double)battles,
+      separations,
+      separations == 0 ? 0.0 : separation_time_total / (double)separations,
+      separation_time_max,
+      collided_battles == 0
+          ? 0.0
+          : first_collision_time_total / (double)collided_battles,
+      elapsed);
+  return 0;
+}
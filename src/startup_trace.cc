@@ -0,0 +1,96 @@
+#include "startup_trace.h"
+
+// Standard library includes.
+#include <chrono>
+#include <fstream>
+#include <vector>
+
+// Third party includes.
+#include <raylib.h>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Phase {
+  const char *name;
+  Clock::time_point start;
+  Clock::time_point end;
+  int depth;
+};
+
+/// Static initialization runs before main(), so this is the process start as
+/// far as this program can tell.
+const Clock::time_point trace_start = Clock::now();
+std::vector<Phase> phases;
+std::string json_path;
+int depth = 0;
+bool finished = false;
+
+double to_ms(Clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void write_json(double first_frame_ms) {
+  std::ofstream ofs(json_path, std::ios_base::trunc);
+  ofs << "{\"first_frame_ms\":" << first_frame_ms << ",\"traceEvents\":[";
+  for (std::size_t idx = 0; idx < phases.size(); ++idx) {
+    const auto &phase = phases[idx];
+    ofs << (idx == 0 ? "" : ",") << "{\"name\":\"" << phase.name
+        << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+        << to_ms(phase.start - trace_start) * 1000.0
+        << ",\"dur\":" << to_ms(phase.end - phase.start) * 1000.0 << '}';
+  }
+  ofs << "]}\n";
+  if (!ofs.good()) {
+    TraceLog(LOG_WARNING, "Failed to write startup trace to \"%s\"!",
+             json_path.c_str());
+  }
+}
+}  // namespace
+
+StartupTrace::Scope::Scope(const char *name) : idx(-1) {
+  if (!finished) {
+    idx = (long)phases.size();
+    phases.push_back(Phase{name, Clock::now(), Clock::time_point{}, depth++});
+  }
+}
+
+StartupTrace::Scope::~Scope() {
+  if (idx >= 0) {
+    phases[(std::size_t)idx].end = Clock::now();
+    --depth;
+  }
+}
+
+void StartupTrace::set_json_path(std::string path) {
+  json_path = std::move(path);
+}
+
+double StartupTrace::finish() {
+  double first_frame_ms = to_ms(Clock::now() - trace_start);
+  if (finished) {
+    return first_frame_ms;
+  }
+  finished = true;
+  for (auto &phase : phases) {
+    if (phase.end == Clock::time_point{}) {
+      // Still running, e.g. the scope that called finish().
+      phase.end = Clock::now();
+    }
+  }
+
+  TraceLog(LOG_INFO, "Startup took %.2f ms to the first frame:",
+           first_frame_ms);
+  for (const auto &phase : phases) {
+    TraceLog(LOG_INFO, "  %*s%-*s %8.2f ms", phase.depth * 2, "",
+             32 - phase.depth * 2, phase.name, to_ms(phase.end - phase.start));
+  }
+
+  if (!json_path.empty()) {
+    write_json(first_frame_ms);
+  }
+
+  return first_frame_ms;
+}
+
+bool StartupTrace::is_finished() { return finished; }
@@ -0,0 +1,36 @@
+#ifndef SEODISPARATE_COM_GANDER_BATTLE_STARTUP_TRACE_H_
+#define SEODISPARATE_COM_GANDER_BATTLE_STARTUP_TRACE_H_
+
+#include <string>
+
+/// Times the phases of startup up to the first presented frame. Phases
+/// entered after finish() are not recorded, so Scopes can stay in code that
+/// also runs later (e.g. screen constructors).
+namespace StartupTrace {
+/// Times the enclosing block as one phase. Phases may nest.
+class Scope {
+ public:
+  explicit Scope(const char *name);
+  ~Scope();
+
+  // No copy.
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+
+ private:
+  /// Index into the recorded phases, or -1 if not recording.
+  long idx;
+};
+
+/// If set before finish(), the phases are also written there as a Chrome
+/// trace ("chrome://tracing" or Perfetto can open it).
+void set_json_path(std::string path);
+
+/// Call once the first frame is presented. Logs a summary and writes the JSON
+/// file if set. Returns the time to first frame in milliseconds.
+double finish();
+
+bool is_finished();
+}  // namespace StartupTrace
+
+#endif
@@ -1,23 +1,491 @@
-#include <iostream>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
 
-#include <ResourcePacker.hpp>
+#include "resource_archive.h"
 
-int main(int argc, char **argv) {
-  if (argc != 3) {
-    std::cout << "binary <pack_name> <dir_containing_files>\n";
-    return 1;
+#ifdef SEODISPARATE_RESOURCE_PACK_COOK
+#include <raylib.h>
+
+#include <bit>
+#include <random>
+
+#include "cooked_image.h"
+#endif
+
+#ifdef SEODISPARATE_RESOURCE_PACK_SCRIPTS
+extern "C" {
+#include <lauxlib.h>
+#include <lualib.h>
+}
+
+#include <duktape.h>
+
+#include "script_cache.h"
+
+// Referenced by duk_config.h's DUK_USE_EXEC_TIMEOUT_CHECK, compiling never
+// times out.
+extern "C" duk_bool_t gander_duk_exec_timeout(void *) { return 0; }
+#endif
+
+namespace {
+/// Bump when cooking or transcoding changes, so that every entry is redone.
+constexpr std::uint64_t PACK_RECIPE_VERSION = 3;
+
+struct PackOptions {
+  bool music_qoa;
+};
+
+bool is_music(const std::filesystem::path &path) {
+  return path.extension() == ".mp3" || path.extension() == ".ogg" ||
+         path.extension() == ".flac" || path.extension() == ".wav";
+}
+
+bool is_script(const std::filesystem::path &path) {
+  return path.extension() == ".lua" || path.extension() == ".js";
+}
+
+#ifdef SEODISPARATE_RESOURCE_PACK_COOK
+/// Images cooked without mipmaps, so they sample the same as when loaded from
+/// loose files. Blue noise averages away to flat gray when minified.
+constexpr std::array<std::string_view, 1> UNMIPMAPPED_IMAGES = {
+    "blue_noise_256x256.png"};
+
+/// Decodes the image and generates its mipmaps if "mipmaps" is set, see
+/// cooked_image.h. Returns an empty View if it can't be decoded, so it is
+/// packed as is.
+ResourceHandler::View cook_image(const std::filesystem::path &path,
+                                 const ResourceHandler::View &source,
+                                 bool mipmaps) {
+  Image image = LoadImageFromMemory(path.extension().string().c_str(),
+                                    source.u_data(), source.i_size());
+  if (!IsImageValid(image)) {
+    return ResourceHandler::View();
+  }
+
+  // OpenGL ES 2 (WebGL) can only mipmap power-of-two textures.
+  if (mipmaps && std::has_single_bit((unsigned int)image.width) &&
+      std::has_single_bit((unsigned int)image.height)) {
+    ImageMipmaps(&image);
   }
 
-  const std::filesystem::path res{argv[2]};
-  std::list<std::string> files;
+  std::size_t size = 0;
+  for (int level = 0, width = image.width, height = image.height;
+       level < image.mipmaps; ++level) {
+    size += (std::size_t)GetPixelDataSize(width, height, image.format);
+    width = std::max(width / 2, 1);
+    height = std::max(height / 2, 1);
+  }
+
+  auto bytes = std::make_shared<std::vector<std::byte> >(CookedImage::write(
+      CookedImage::Header{image.width, image.height, image.mipmaps,
+                          image.format},
+      image.data, size));
+  UnloadImage(image);
+
+  return ResourceHandler::View(std::span<const std::byte>(*bytes), bytes);
+}
 
-  for (auto const & dir_entry : std::filesystem::directory_iterator{res}) {
+/// Makes each transcode_music() temp file name unique, as packer threads and
+/// other packer runs share the temp directory, and may transcode identical
+/// music at the same time.
+std::string unique_temp_suffix() {
+  static const std::uint64_t process_token = [] {
+    std::random_device device;
+    std::uint64_t high = device();
+    return (high << 32U) | device();
+  }();
+  static std::atomic<std::uint64_t> counter(0);
+  return std::to_string(process_token) + "_" + std::to_string(counter++);
+}
+
+/// Re-encodes music as QOA, which is much cheaper to decode while streaming
+/// than MP3. Returns an empty View on failure, so it is packed as is.
+ResourceHandler::View transcode_music(const std::filesystem::path &path,
+                                      const ResourceHandler::View &source,
+                                      std::uint64_t source_hash) {
+  Wave wave = LoadWaveFromMemory(path.extension().string().c_str(),
+                                 source.u_data(), source.i_size());
+  if (!IsWaveValid(wave)) {
+    return ResourceHandler::View();
+  }
+
+  // QOA is 16-bit only.
+  if (wave.sampleSize != 16) {
+    WaveFormat(&wave, (int)wave.sampleRate, 16, (int)wave.channels);
+  }
+
+  // raylib can only export QOA to a file.
+  auto qoa_path = std::filesystem::temp_directory_path() /
+                  ("gander_battle_" + std::to_string(source_hash) + "_" +
+                   unique_temp_suffix() + ".qoa");
+  bool exported = ExportWave(wave, qoa_path.string().c_str());
+  UnloadWave(wave);
+  if (!exported) {
+    return ResourceHandler::View();
+  }
+
+  auto view = ResourceHandler::map_file(qoa_path.string().c_str());
+  // Still readable through the View, as it was mapped or read already.
+  std::filesystem::remove(qoa_path);
+
+  return view.with_file_type(".qoa");
+}
+#endif
+
+#ifdef SEODISPARATE_RESOURCE_PACK_SCRIPTS
+/// Compiles a Lua script to bytecode, keeping debug info for error messages.
+/// Returns an empty View if it doesn't compile, so it is packed as source and
+/// the error shows when it is run.
+ResourceHandler::View precompile_lua(const std::string &name,
+                                     const ResourceHandler::View &source) {
+  auto bytes = std::make_shared<std::vector<std::byte> >();
+  // Named like ScriptCache::load_lua_file() names its chunks.
+  std::string chunk_name = "@res/" + name;
+
+  lua_State *l = luaL_newstate();
+  if (luaL_loadbufferx(l, reinterpret_cast<const char *>(source.u_data()),
+                       source.data().size(), chunk_name.c_str(),
+                       "t") == LUA_OK) {
+    lua_dump(
+        l,
+        [](lua_State *, const void *p, std::size_t size, void *ud) {
+          if (p != nullptr) {
+            auto *out = static_cast<std::vector<std::byte> *>(ud);
+            const auto *begin = static_cast<const std::byte *>(p);
+            out->insert(out->end(), begin, begin + size);
+          }
+          return 0;
+        },
+        bytes.get(), 0);
+  }
+  lua_close(l);
+
+  if (bytes->empty()) {
+    return ResourceHandler::View();
+  }
+  return ResourceHandler::View(std::span<const std::byte>(*bytes), bytes)
+      .with_file_type(SCRIPT_LUA_BYTECODE_TYPE);
+}
+
+/// Compiles a JS script to Duktape bytecode (see duk_dump_function()), kept
+/// with its source in case it is run by another Duktape build. Like
+/// precompile_lua(), returns an empty View if it doesn't compile.
+ResourceHandler::View precompile_js(const std::string &name,
+                                    const ResourceHandler::View &source) {
+  auto bytes = std::make_shared<std::vector<std::byte> >();
+  std::string file_name = "res/" + name;
+
+  duk_context *ctx = duk_create_heap_default();
+  // +1
+  duk_push_string(ctx, file_name.c_str());
+  // -1, +1
+  if (duk_pcompile_lstring_filename(
+          ctx, 0, reinterpret_cast<const char *>(source.u_data()),
+          source.data().size()) == DUK_EXEC_SUCCESS) {
+    // -1, +1
+    duk_dump_function(ctx);
+    duk_size_t size = 0;
+    const auto *begin =
+        static_cast<const std::byte *>(duk_get_buffer(ctx, -1, &size));
+    // Laid out as script_cache.h describes.
+    auto source_size = (std::uint32_t)source.data().size();
+    auto marker = std::as_bytes(std::span(SCRIPT_JS_BYTECODE_MARKER));
+    bytes->resize(sizeof(source_size));
+    std::memcpy(bytes->data(), &source_size, sizeof(source_size));
+    bytes->insert(bytes->end(), source.data().begin(), source.data().end());
+    bytes->insert(bytes->end(), marker.begin(), marker.end());
+    bytes->insert(bytes->end(), begin, begin + size);
+  }
+  duk_destroy_heap(ctx);
+
+  if (bytes->empty()) {
+    return ResourceHandler::View();
+  }
+  return ResourceHandler::View(std::span<const std::byte>(*bytes), bytes)
+      .with_file_type(SCRIPT_JS_BYTECODE_TYPE);
+}
+#endif
+
+/// Cooks, transcodes or compiles "source" if needed. "log" gets what was
+/// done.
+ResourceHandler::View convert_entry(const std::string &name,
+                                    const std::filesystem::path &path,
+                                    const ResourceHandler::View &source,
+                                    std::uint64_t source_hash,
+                                    const PackOptions &options,
+                                    std::string &log) {
+#ifdef SEODISPARATE_RESOURCE_PACK_COOK
+  if (options.music_qoa && is_music(path)) {
+    if (auto qoa = transcode_music(path, source, source_hash); !qoa.empty()) {
+      log = "transcoded to " + std::to_string(qoa.data().size()) +
+            " bytes of QOA";
+      return qoa;
+    }
+    log = "failed to transcode, adding as is";
+  } else if (path.extension() == ".png") {
+    bool mipmaps = std::find(UNMIPMAPPED_IMAGES.begin(),
+                             UNMIPMAPPED_IMAGES.end(),
+                             name) == UNMIPMAPPED_IMAGES.end();
+    if (auto cooked = cook_image(path, source, mipmaps); !cooked.empty()) {
+      log = "cooked to " + std::to_string(cooked.data().size()) + " bytes";
+      return cooked;
+    }
+    log = "failed to cook, adding as is";
+  }
+#else
+  if (options.music_qoa && is_music(path)) {
+    log = "not transcoding, built without raylib";
+  }
+#endif
+#ifdef SEODISPARATE_RESOURCE_PACK_SCRIPTS
+  if (is_script(path)) {
+    auto compiled = path.extension() == ".lua" ? precompile_lua(name, source)
+                                               : precompile_js(name, source);
+    if (!compiled.empty()) {
+      log = "compiled to " + std::to_string(compiled.data().size()) +
+            " bytes of bytecode";
+      return compiled;
+    }
+    log = "failed to compile, adding as source";
+  }
+#endif
+  return source;
+}
+
+/// Make style depfile, listing every input so the packfile is rebuilt when
+/// one changes. Directories are listed too, to catch added or removed files.
+bool write_depfile(const char *depfile, const char *pack_name,
+                   const std::vector<std::filesystem::path> &inputs) {
+  auto escape = [](std::string path) {
+    std::string escaped;
+    for (char c : path) {
+      if (c == ' ' || c == '#') {
+        escaped.push_back('\\');
+      } else if (c == '$') {
+        escaped.push_back('$');
+      }
+      escaped.push_back(c);
+    }
+    return escaped;
+  };
+
+  std::ofstream ofs(depfile, std::ios_base::trunc);
+  ofs << escape(pack_name) << ':';
+  for (const auto &input : inputs) {
+    ofs << " \\\n  " << escape(input.generic_string());
+  }
+  ofs << '\n';
+  return ofs.good();
+}
+
+int pack(const char *pack_name, const std::filesystem::path &res,
+         const PackOptions &options, const char *depfile) {
+#ifdef SEODISPARATE_RESOURCE_PACK_COOK
+  SetTraceLogLevel(LOG_WARNING);
+#endif
+
+  std::vector<std::filesystem::path> files;
+  std::vector<std::filesystem::path> depends{res};
+  for (auto const &dir_entry :
+       std::filesystem::recursive_directory_iterator{res}) {
     if (dir_entry.is_regular_file()) {
-      files.push_back(dir_entry.path().string());
-      std::cout << "Adding file \"" << files.back() << "\"...\n";
+      files.push_back(dir_entry.path());
+    } else if (dir_entry.is_directory()) {
+      depends.push_back(dir_entry.path());
+    }
+  }
+  // Same order every run, so unchanged inputs give an identical packfile.
+  std::sort(files.begin(), files.end());
+  depends.insert(depends.end(), files.begin(), files.end());
+
+  // Entries whose source hash matches are copied over instead of redone.
+  ResourceArchive previous;
+  previous.open(pack_name);
+
+  std::vector<ResourceArchive::Input> entries(files.size());
+  std::vector<std::string> logs(files.size());
+  std::atomic<std::size_t> next_file{0};
+  std::atomic<bool> failed{false};
+  // The version keeps to the high bits, so a bump can't cancel out options.
+  std::uint64_t seed =
+      (PACK_RECIPE_VERSION << 32U) | (options.music_qoa ? 2U : 0U);
+#ifdef SEODISPARATE_RESOURCE_PACK_COOK
+  seed |= 4;
+#endif
+#ifdef SEODISPARATE_RESOURCE_PACK_SCRIPTS
+  seed |= 8;
+  // Bytecode only loads into the engine that compiled it, so scripts are
+  // recompiled whenever either engine is updated.
+  constexpr std::array<std::int64_t, 2> engine_versions = {LUA_VERSION_NUM,
+                                                           DUK_VERSION};
+  std::uint64_t script_seed = ResourceArchive::hash_bytes(
+      std::as_bytes(std::span(engine_versions)), seed);
+#else
+  std::uint64_t script_seed = seed;
+#endif
+
+  auto worker = [&] {
+    for (std::size_t idx = next_file++; idx < files.size();
+         idx = next_file++) {
+      const auto &path = files[idx];
+      auto &entry = entries[idx];
+      entry.name = path.lexically_relative(res).generic_string();
+
+      auto source = ResourceHandler::map_file(path.string().c_str());
+      if (source.empty() && !std::filesystem::is_empty(path)) {
+        logs[idx] = "failed to read";
+        failed = true;
+        continue;
+      }
+      entry.source_hash = ResourceArchive::hash_bytes(
+          source.data(), is_script(path) ? script_seed : seed);
+
+      if (auto old = previous.get_entry(entry.name);
+          old.has_value() && old->source_hash == entry.source_hash) {
+        entry.view = previous.get(entry.name);
+        logs[idx] = "unchanged";
+      } else {
+        entry.view = convert_entry(entry.name, path, source,
+                                   entry.source_hash, options, logs[idx]);
+        if (logs[idx].empty()) {
+          logs[idx] = "added";
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  unsigned int thread_count =
+      std::clamp(std::thread::hardware_concurrency(), 1U, 16U);
+  for (unsigned int idx = 0; idx < thread_count; ++idx) {
+    threads.emplace_back(worker);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (std::size_t idx = 0; idx < files.size(); ++idx) {
+    std::cout << '"' << files[idx].string() << "\": " << logs[idx] << '\n';
+  }
+  if (failed) {
+    return 1;
+  }
+
+  if (!ResourceArchive::write(pack_name, entries)) {
+    std::cout << "Failed to write \"" << pack_name << "\"!\n";
+    return 1;
+  }
+
+  if (depfile && !write_depfile(depfile, pack_name, depends)) {
+    std::cout << "Failed to write \"" << depfile << "\"!\n";
+    return 1;
+  }
+
+  return 0;
+}
+
+/// Packs "count" synthetic assets, then times opening the packfile (cold) and
+/// looking up every asset after it is open (warm).
+int bench(int count) {
+  using Clock = std::chrono::steady_clock;
+
+  auto dir = std::filesystem::temp_directory_path() / "gander_battle_rp_bench";
+  std::filesystem::create_directories(dir);
+  auto pack_name = (dir / "data").string();
+
+  std::vector<std::string> names;
+  std::vector<ResourceArchive::Input> entries;
+  std::vector<std::byte> bytes(4096, std::byte{0x5A});
+  auto owner = std::make_shared<std::vector<std::byte> >(bytes);
+  for (int idx = 0; idx < count; ++idx) {
+    names.push_back("asset_" + std::to_string(idx) + ".png");
+    entries.push_back(ResourceArchive::Input{
+        names.back(),
+        ResourceHandler::View(std::span<const std::byte>(*owner), owner),
+        0});
+  }
+  if (!ResourceArchive::write(pack_name.c_str(), entries)) {
+    std::cout << "Failed to write \"" << pack_name << "\"!\n";
+    return 1;
+  }
+
+  auto start = Clock::now();
+  ResourceArchive archive;
+  bool opened = archive.open(pack_name.c_str());
+  auto first = archive.get(names.front());
+  auto cold = Clock::now() - start;
+  if (!opened || first.empty()) {
+    std::cout << "Failed to read back \"" << pack_name << "\"!\n";
+    return 1;
+  }
+
+  constexpr int WARM_PASSES = 100;
+  std::size_t found = 0;
+  start = Clock::now();
+  for (int pass = 0; pass < WARM_PASSES; ++pass) {
+    for (const auto &name : names) {
+      found += archive.get(name).empty() ? 0 : 1;
     }
   }
+  auto warm = Clock::now() - start;
+
+  std::filesystem::remove_all(dir);
+
+  std::cout << "Assets:                  " << count << '\n'
+            << "Cold open+first lookup:  "
+            << std::chrono::duration<double, std::micro>(cold).count()
+            << " us\n"
+            << "Warm lookup:             "
+            << std::chrono::duration<double, std::nano>(warm).count() /
+                   (double)(names.size() * WARM_PASSES)
+            << " ns (" << found << " found)\n";
+
+  return 0;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc == 3 && std::string(argv[1]) == "--bench") {
+    int count = std::atoi(argv[2]);
+    if (count <= 0) {
+      std::cout << "--bench expects a positive asset count\n";
+      return 1;
+    }
+    return bench(count);
+  }
+
+  PackOptions options{false};
+  const char *depfile = nullptr;
+  int idx = 1;
+  for (; idx < argc && std::strncmp(argv[idx], "--", 2) == 0; ++idx) {
+    if (std::strcmp(argv[idx], "--music-qoa") == 0) {
+      options.music_qoa = true;
+    } else if (std::strcmp(argv[idx], "--depfile") == 0 && idx + 1 < argc) {
+      depfile = argv[++idx];
+    } else {
+      break;
+    }
+  }
+
+  if (argc - idx != 2) {
+    std::cout << "binary [--music-qoa] [--depfile <path>] <pack_name> "
+                 "<dir_containing_files>\n"
+              << "binary --bench <asset_count>\n";
+    return 1;
+  }
 
-  return RP::createPackfile(files, std::string(argv[1])) ? 0 : 1;
+  return pack(argv[idx], std::filesystem::path{argv[idx + 1]}, options,
+              depfile);
 }
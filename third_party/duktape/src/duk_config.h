@@ -2962,7 +2962,8 @@ typedef struct duk_hthread duk_context;
 #undef DUK_USE_EXEC_INDIRECT_BOUND_CHECK
 #undef DUK_USE_EXEC_PREFER_SIZE
 #define DUK_USE_EXEC_REGCONST_OPTIMIZE
-#undef DUK_USE_EXEC_TIMEOUT_CHECK
+/* GanderBattle: per-tick script hooks are aborted past their frame budget. */
+#define DUK_USE_EXEC_TIMEOUT_CHECK(udata) gander_duk_exec_timeout((udata))
 #undef DUK_USE_EXPLICIT_NULL_INIT
 #undef DUK_USE_EXTSTR_FREE
 #undef DUK_USE_EXTSTR_INTERN_CHECK
@@ -3004,7 +3005,7 @@ typedef struct duk_hthread duk_context;
 #define DUK_USE_HTML_COMMENTS
 #define DUK_USE_IDCHAR_FASTPATH
 #undef DUK_USE_INJECT_HEAP_ALLOC_ERROR
-#undef DUK_USE_INTERRUPT_COUNTER
+#define DUK_USE_INTERRUPT_COUNTER
 #undef DUK_USE_INTERRUPT_DEBUG_FIXUP
 #define DUK_USE_JC
 #define DUK_USE_JSON_BUILTIN
@@ -3171,6 +3172,12 @@ typedef struct duk_hthread duk_context;
 /* No provider for DUK_USE_GET_MONOTONIC_TIME(), fall back to DUK_USE_DATE_GET_NOW(). */
 #endif
 
+/* GanderBattle: defined in screen_debug.cc. */
+#if defined(__cplusplus)
+extern "C"
+#endif
+duk_bool_t gander_duk_exec_timeout(void *udata);
+
 #endif  /* DUK_COMPILING_DUKTAPE */
 
 /*